@@ -0,0 +1,120 @@
+#pragma once
+
+// Mesures et resultats JSON communs aux outils de mesure du driver (parquet_reader_bench, parquet_reader_replay)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+inline uint64_t PeakRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+inline double ElapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+inline std::string JsonString(const std::string& text) {
+    std::string json = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            json += escaped;
+        }
+        else {
+            json += c;
+        }
+    }
+    return json + "\"";
+}
+
+inline std::string JsonNumber(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.6g", value);
+    return text;
+}
+
+// Objet JSON, ecrit sur une ligne ou un champ par ligne
+class JsonObject {
+
+    public:
+        // Valeur deja ecrite en JSON
+        JsonObject& addJson(const std::string& key, const std::string& json) {
+            fields.emplace_back(key, json);
+            return *this;
+        }
+        JsonObject& add(const std::string& key, const std::string& text) { return addJson(key, JsonString(text)); }
+        JsonObject& add(const std::string& key, const char* text) { return addJson(key, JsonString(text)); }
+        JsonObject& add(const std::string& key, double value) { return addJson(key, JsonNumber(value)); }
+        JsonObject& add(const std::string& key, uint64_t value) { return addJson(key, std::to_string(value)); }
+        JsonObject& add(const std::string& key, int64_t value) { return addJson(key, std::to_string(value)); }
+
+        std::string str(bool multiline = false) const {
+            std::string json = multiline ? "{\n  " : "{";
+            for (size_t i = 0; i < fields.size(); i++) {
+                if (i > 0) json += multiline ? ",\n  " : ", ";
+                json += JsonString(fields[i].first) + ": ";
+                for (char c : fields[i].second) {
+                    json += c;
+                    if (multiline && c == '\n') json += "  ";    // objets imbriques sur plusieurs lignes
+                }
+            }
+            return json + (multiline ? "\n}" : "}");
+        }
+
+    private:
+        std::vector<std::pair<std::string, std::string>> fields;
+};
+
+// Statistiques de latences, en microsecondes
+inline std::string LatencyStats(std::vector<double> samples) {
+    JsonObject stats;
+    stats.add("count", static_cast<uint64_t>(samples.size()));
+    if (samples.empty()) return stats.str();
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    auto percentile = [&](double p) {
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(p * static_cast<double>(samples.size())))];
+    };
+    stats.add("min_us", samples.front())
+        .add("mean_us", sum / static_cast<double>(samples.size()))
+        .add("p50_us", percentile(0.50))
+        .add("p90_us", percentile(0.90))
+        .add("p99_us", percentile(0.99))
+        .add("max_us", samples.back());
+    return stats.str();
+}
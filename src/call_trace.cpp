@@ -0,0 +1,248 @@
+#include "call_trace.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Version 2 : ajout de driver_getSplitPoints ; les traces de version 1 restent lisibles
+constexpr uint32_t kTraceVersion = 2;
+constexpr char kTraceMagic[8] = { 'K', 'H', 'P', 'Q', 'T', 'R', 'C', '\0' };
+
+bool HasPath(TraceCall call) {
+    return call == TraceCall::FileExists || call == TraceCall::DirExists || call == TraceCall::GetFileSize || call == TraceCall::Open;
+}
+
+void PutVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void PutSigned(std::vector<uint8_t>& out, int64_t value) {
+    PutVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void PutValues(std::vector<uint8_t>& out, const std::vector<int64_t>& values) {
+    PutVarint(out, values.size());
+    for (int64_t value : values) PutSigned(out, value);
+}
+
+// Lecture des enregistrements ; une lecture au-dela de la fin rend la trace invalide
+class TraceReader {
+
+    public:
+        TraceReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+        bool done() const { return pos >= size; }
+
+        uint8_t byte() {
+            if (pos >= size) throw std::runtime_error("Truncated trace file");
+            return data[pos++];
+        }
+
+        uint64_t varint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                const uint8_t b = byte();
+                value |= static_cast<uint64_t>(b & 0x7f) << shift;
+                if ((b & 0x80) == 0) return value;
+            }
+            throw std::runtime_error("Invalid trace file: varint too long");
+        }
+
+        int64_t signedVarint() {
+            const uint64_t value = varint();
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        std::vector<int64_t> values() {
+            const uint64_t count = varint();
+            // Chaque valeur occupe au moins un octet
+            if (count > size - pos) throw std::runtime_error("Truncated trace file");
+            std::vector<int64_t> result(static_cast<size_t>(count));
+            for (int64_t& value : result) value = signedVarint();
+            return result;
+        }
+
+        std::string text(size_t len) {
+            if (len > size - pos) throw std::runtime_error("Truncated trace file");
+            std::string value(reinterpret_cast<const char*>(data + pos), len);
+            pos += len;
+            return value;
+        }
+
+    private:
+        const uint8_t* data;
+        size_t size;
+        size_t pos = 0;
+};
+
+// Numero du thread appelant, attribue a son premier appel trace
+uint32_t ThreadNumber() {
+    static std::atomic<uint32_t> next_thread{ 1 };
+    thread_local const uint32_t thread = next_thread++;
+    return thread;
+}
+
+} // namespace
+
+const char* TraceCallName(TraceCall call) {
+    switch (call) {
+    case TraceCall::FileExists: return "driver_fileExists";
+    case TraceCall::DirExists: return "driver_dirExists";
+    case TraceCall::GetFileSize: return "driver_getFileSize";
+    case TraceCall::Open: return "driver_fopen";
+    case TraceCall::Close: return "driver_fclose";
+    case TraceCall::Read: return "driver_fread";
+    case TraceCall::PositionalRead: return "driver_pread";
+    case TraceCall::Seek: return "driver_fseek";
+    case TraceCall::LineOffset: return "driver_getLineOffset";
+    case TraceCall::SplitPoints: return "driver_getSplitPoints";
+    }
+    return nullptr;
+}
+
+CallTrace* CallTrace::instance() {
+    static std::unique_ptr<CallTrace> trace = []() -> std::unique_ptr<CallTrace> {
+        const char* env = std::getenv("KHIOPS_PARQUET_TRACE");
+        if (env == nullptr || *env == '\0') return nullptr;
+
+        std::string path = env;
+        const size_t pid = path.find("%p");
+        if (pid != std::string::npos) path.replace(pid, 2, std::to_string(getpid()));
+
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) return nullptr;
+        return std::unique_ptr<CallTrace>(new CallTrace(file));
+    }();
+    return trace.get();
+}
+
+CallTrace::CallTrace(FILE* file) : file(file), origin(std::chrono::steady_clock::now()) {
+    buffer.reserve(kBufferBytes + 4096);
+    buffer.insert(buffer.end(), kTraceMagic, kTraceMagic + sizeof(kTraceMagic));
+    for (int shift = 0; shift < 32; shift += 8) {
+        buffer.push_back(static_cast<uint8_t>(kTraceVersion >> shift));
+    }
+}
+
+CallTrace::~CallTrace() {
+    std::lock_guard<std::mutex> lock(mutex);
+    flush();
+    std::fclose(file);
+}
+
+uint64_t CallTrace::now() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count());
+}
+
+TraceRecord CallTrace::begin(TraceCall call, const void* stream, int64_t arg0, int64_t arg1, const char* path) {
+    TraceRecord record;
+    record.call = call;
+    record.thread = ThreadNumber();
+    record.args[0] = arg0;
+    record.args[1] = arg1;
+    if (path != nullptr) record.path = path;
+    if (stream != nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = streams.find(stream);
+        if (it != streams.end()) record.stream = it->second;
+    }
+    record.start_ns = now();
+    return record;
+}
+
+void CallTrace::openStream(TraceRecord& record, const void* handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    record.stream = next_stream++;
+    streams[handle] = record.stream;
+}
+
+void CallTrace::closeStream(const void* handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    streams.erase(handle);
+}
+
+void CallTrace::append(TraceRecord& record) {
+    record.duration_ns = now() - record.start_ns;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    buffer.push_back(static_cast<uint8_t>(record.call));
+    PutVarint(buffer, record.thread);
+    PutVarint(buffer, record.stream);
+    PutSigned(buffer, record.args[0]);
+    PutSigned(buffer, record.args[1]);
+    PutSigned(buffer, record.result);
+    PutVarint(buffer, record.start_ns);
+    PutVarint(buffer, record.duration_ns);
+    if (HasPath(record.call)) {
+        PutVarint(buffer, record.path.size());
+        buffer.insert(buffer.end(), record.path.begin(), record.path.end());
+    }
+    if (record.call == TraceCall::SplitPoints) {
+        PutValues(buffer, record.targets);
+        PutValues(buffer, record.split_points);
+    }
+
+    // La trace est complete apres la fermeture des flux, meme si le processus est interrompu ensuite
+    if (buffer.size() >= kBufferBytes || record.call == TraceCall::Close) flush();
+}
+
+void CallTrace::flush() {
+    if (buffer.empty()) return;
+    std::fwrite(buffer.data(), 1, buffer.size(), file);
+    std::fflush(file);
+    buffer.clear();
+}
+
+std::vector<TraceRecord> ReadTrace(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Unable to open trace file: " + path);
+    const std::vector<uint8_t> content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    const size_t header_size = sizeof(kTraceMagic) + sizeof(uint32_t);
+    if (content.size() < header_size || std::memcmp(content.data(), kTraceMagic, sizeof(kTraceMagic)) != 0) {
+        throw std::runtime_error("Not a trace file: " + path);
+    }
+    uint32_t version = 0;
+    for (int b = 0; b < 4; b++) {
+        version |= static_cast<uint32_t>(content[sizeof(kTraceMagic) + b]) << (8 * b);
+    }
+    if (version == 0 || version > kTraceVersion) throw std::runtime_error("Unsupported trace version: " + std::to_string(version));
+
+    std::vector<TraceRecord> records;
+    TraceReader reader(content.data() + header_size, content.size() - header_size);
+    while (!reader.done()) {
+        TraceRecord record;
+        record.call = static_cast<TraceCall>(reader.byte());
+        if (TraceCallName(record.call) == nullptr) throw std::runtime_error("Invalid trace file: unknown call");
+        record.thread = static_cast<uint32_t>(reader.varint());
+        record.stream = static_cast<uint32_t>(reader.varint());
+        record.args[0] = reader.signedVarint();
+        record.args[1] = reader.signedVarint();
+        record.result = reader.signedVarint();
+        record.start_ns = reader.varint();
+        record.duration_ns = reader.varint();
+        if (HasPath(record.call)) record.path = reader.text(static_cast<size_t>(reader.varint()));
+        if (record.call == TraceCall::SplitPoints) {
+            record.targets = reader.values();
+            record.split_points = reader.values();
+        }
+        records.push_back(std::move(record));
+    }
+    return records;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Trace binaire des appels du driver, pour rejouer hors production les sequences d'acces de Khiops.
+// Activee par KHIOPS_PARQUET_TRACE=<fichier> ("%p" y est remplace par le pid du processus).
+// Format : magic "KHPQTRC", version (uint32 little-endian), puis un enregistrement par appel : un octet
+// d'appel suivi d'entiers varint (LEB128, zigzag pour les entiers signes) : thread, flux, arguments,
+// resultat, debut et duree en ns, puis pour les appels sur un nom de fichier sa longueur et ses octets, et pour
+// driver_getSplitPoints le nombre de cibles et leurs valeurs puis le nombre de points de coupure et leurs valeurs.
+
+// Appels traces ; les valeurs sont celles du format
+enum class TraceCall : uint8_t {
+    FileExists = 1,
+    DirExists = 2,
+    GetFileSize = 3,
+    Open = 4,
+    Close = 5,
+    Read = 6,
+    PositionalRead = 7,
+    Seek = 8,
+    LineOffset = 9,
+    SplitPoints = 10,
+};
+
+// Nom de la fonction du driver, nullptr pour une valeur inconnue
+const char* TraceCallName(TraceCall call);
+
+// Appel du driver. Les handles sont remplaces par des numeros de flux attribues a l'ouverture (0 pour un
+// handle nul ou inconnu), et le resultat de driver_fopen par 1 (succes) ou 0.
+// Arguments : mode (fopen), size et count (fread), offset et len (pread), offset et whence (fseek), line,
+// count et tolerance (getSplitPoints).
+struct TraceRecord {
+    TraceCall call = TraceCall::FileExists;
+    uint32_t thread = 0;
+    uint32_t stream = 0;
+    int64_t args[2] = { 0, 0 };
+    int64_t result = 0;
+    uint64_t start_ns = 0;          // depuis le debut de la trace
+    uint64_t duration_ns = 0;
+    std::string path;               // appels sur un nom de fichier
+    std::vector<int64_t> targets;       // getSplitPoints
+    std::vector<int64_t> split_points;  // getSplitPoints, vide si l'appel a echoue
+};
+
+// Trace du processus ; les enregistrements sont ecrits par blocs, et a chaque fermeture de flux
+class CallTrace {
+
+    public:
+        // Returns the trace enabled by KHIOPS_PARQUET_TRACE, nullptr if disabled or if the file cannot be created
+        static CallTrace* instance();
+
+        ~CallTrace();
+
+        // Debut d'un appel sur le handle stream
+        TraceRecord begin(TraceCall call, const void* stream, int64_t arg0 = 0, int64_t arg1 = 0, const char* path = nullptr);
+
+        // Fin d'un appel : enregistre result et la duree (thread-safe). Returns result.
+        template <typename T>
+        T end(TraceRecord& record, T result) {
+            record.result = static_cast<int64_t>(result);
+            append(record);
+            return result;
+        }
+
+        // Numero de flux d'un handle ouvert, a attribuer avant que l'appel ne soit enregistre
+        void openStream(TraceRecord& record, const void* handle);
+
+        // Libere le numero de flux d'un handle avant sa fermeture
+        void closeStream(const void* handle);
+
+    private:
+        static constexpr size_t kBufferBytes = 64 * 1024;
+
+        FILE* file;
+        const std::chrono::steady_clock::time_point origin;
+
+        std::mutex mutex;
+        std::vector<uint8_t> buffer;
+        std::unordered_map<const void*, uint32_t> streams;
+        uint32_t next_stream = 1;
+
+        explicit CallTrace(FILE* file);
+
+        uint64_t now() const;
+        void append(TraceRecord& record);
+        void flush();
+};
+
+// Throws if the file is not a trace or is truncated
+std::vector<TraceRecord> ReadTrace(const std::string& path);
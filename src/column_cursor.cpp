@@ -0,0 +1,535 @@
+#include "column_cursor.h"
+#include "value_format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <arrow/buffer.h>
+#include <arrow/io/memory.h>
+#include <arrow/util/config.h>
+
+using parquet::TypedColumnReader;
+using parquet::Type;
+
+namespace {
+
+// Nombre de valeurs decodees par appel a ReadBatch
+constexpr int64_t kCursorBatchSize = 1024;
+
+// Nombre de valeurs decodees par appel a ReadBatch lors de la construction de l'index
+constexpr int64_t kIndexBatchSize = 4096;
+
+template <typename DType>
+class TypedColumnCursor : public ColumnCursor {
+    using T = typename DType::c_type;
+
+    public:
+        TypedColumnCursor(std::shared_ptr<parquet::RowGroupReader> rg_reader, int col, std::shared_ptr<const SkippedPages> pages, PageSeek page_seek)
+            : rg_reader(std::move(rg_reader)), col(col), pages(std::move(pages)), page_seek(std::move(page_seek)) {
+            // Colonne constante : aucune page n'est lue
+            constant = RenderConstantColumn(*this->rg_reader->metadata(), col, constant_text);
+            if (constant) return;
+
+            def_levels.resize(kCursorBatchSize);
+            value_pos.resize(kCursorBatchSize);
+            max_def_level = this->rg_reader->metadata()->schema()->Column(col)->max_definition_level();
+        }
+
+        int64_t writeValue(int64_t row, uint8_t* out) override {
+            if (constant) {
+                std::memcpy(out, constant_text.data(), constant_text.size());
+                return static_cast<int64_t>(constant_text.size());
+            }
+            const int64_t stream_row = pages ? pages->streamRow(row) : row;
+            if (!seek(row, stream_row)) return -1;
+
+            int32_t v = value_pos[stream_row - batch_first_row];
+            if (v < 0) return 0;
+            if (batch_indices) {
+                return static_cast<int64_t>(dictionary.write(indices[v], out));
+            }
+            return static_cast<int64_t>(FormatValue(values[v], out));
+        }
+
+    private:
+        std::shared_ptr<parquet::RowGroupReader> rg_reader;
+        int col;
+        std::shared_ptr<const SkippedPages> pages;
+        PageSeek page_seek;
+
+        std::shared_ptr<parquet::ColumnReader> reader;
+        TypedColumnReader<DType>* typed = nullptr;
+        int16_t max_def_level = 0;
+
+        bool constant = false;
+        std::string constant_text;
+
+        // Column chunk entierement encode par dictionnaire, lu sous forme d'indices tant que le
+        // dictionnaire est suffisamment reutilise
+        bool dictionary_encoded = false;
+        bool batch_indices = false;     // le batch courant contient des indices et non des valeurs
+        DictionaryText<T> dictionary;
+
+        // Lignes comptees dans le flux lu par le reader, sans les pages sautees
+        int64_t next_row = 0;           // ligne de la prochaine valeur a decoder par le reader
+
+        // batch courant : lignes [batch_first_row, batch_first_row + batch_rows)
+        int64_t batch_first_row = 0;
+        int64_t batch_rows = 0;
+        std::vector<T> values;
+        std::vector<int32_t> indices;
+        std::vector<int16_t> def_levels;
+        std::vector<int32_t> value_pos;  // indice de la valeur de chaque ligne dans values (ou indices), -1 si nulle
+
+        // Ouvre la colonne a la page de la ligne row du row group
+        void reopen(int64_t row) {
+            int64_t first_row = 0;
+            reader = OpenColumnReaderAt(*rg_reader, col, pages, page_seek, row, first_row);
+            typed = dynamic_cast<TypedColumnReader<DType>*>(reader.get());
+            if (!typed) throw std::runtime_error("Couldn't open typed column reader");
+
+            dictionary_encoded = reader->GetExposedEncoding() == parquet::ExposedEncoding::DICTIONARY;
+            batch_indices = false;
+
+            next_row = pages ? pages->streamRow(first_row) : first_row;
+            batch_first_row = next_row;
+            batch_rows = 0;
+        }
+
+        bool seek(int64_t row, int64_t stream_row) {
+            if (typed && stream_row >= batch_first_row && stream_row < batch_first_row + batch_rows) {
+                return true;
+            }
+
+            // Premiere lecture ou retour en arriere : la colonne est (re)ouverte
+            if (!typed || stream_row < next_row) {
+                reopen(row);
+            }
+            if (stream_row > next_row) {
+                next_row += typed->Skip(stream_row - next_row);
+                if (next_row != stream_row) return false;
+            }
+            return readBatch();
+        }
+
+        bool readBatch() {
+            int64_t values_read = 0;
+            int64_t levels_read;
+            batch_indices = dictionary_encoded;
+            if (batch_indices) {
+                const T* dict = nullptr;
+                int32_t dict_len = 0;
+                indices.resize(kCursorBatchSize);
+                levels_read = typed->ReadBatchWithDictionary(kCursorBatchSize, def_levels.data(), nullptr,
+                                                             indices.data(), &values_read, &dict, &dict_len);
+                if (levels_read > 0) {
+                    dictionary.reset(dict, dict_len);
+                    // Valeurs presque toutes distinctes : les batchs suivants sont decodes directement
+                    dictionary_encoded = static_cast<int64_t>(dict_len) * kMinDictionaryReuse <= rg_reader->metadata()->num_rows();
+                }
+            }
+            else {
+                values.resize(kCursorBatchSize);
+                levels_read = typed->ReadBatch(kCursorBatchSize, def_levels.data(), nullptr, values.data(), &values_read);
+            }
+            if (levels_read <= 0) {
+                batch_rows = 0;
+                return false;
+            }
+
+            batch_first_row = next_row;
+            batch_rows = levels_read;
+            next_row += levels_read;
+
+            if (values_read == levels_read) {
+                for (int64_t i = 0; i < levels_read; i++) {
+                    value_pos[i] = static_cast<int32_t>(i);
+                }
+            }
+            else {
+                int32_t v = 0;
+                for (int64_t i = 0; i < levels_read; i++) {
+                    value_pos[i] = def_levels[i] == max_def_level ? v++ : -1;
+                }
+            }
+            return true;
+        }
+};
+
+// Colonne constante : aucune page n'est lue
+class ConstantColumnLengths : public ColumnLengths {
+
+    public:
+        explicit ConstantColumnLengths(uint64_t length) : length(length) {}
+
+        void read(const RowRange* ranges, size_t num_ranges, uint64_t* lens) override {
+            for (size_t r = 0; r < num_ranges; r++) {
+                std::fill(lens, lens + ranges[r].num_rows, length);
+                lens += ranges[r].num_rows;
+            }
+        }
+
+    private:
+        uint64_t length;
+};
+
+template <typename DType>
+class TypedColumnLengths : public ColumnLengths {
+    using T = typename DType::c_type;
+
+    public:
+        TypedColumnLengths(parquet::RowGroupReader& rg_reader, int col, std::shared_ptr<const SkippedPages> pages, const PageSeek& seek, int64_t first_row)
+            : pages(std::move(pages)), chunk_rows(rg_reader.metadata()->num_rows()) {
+            int64_t reader_first_row = 0;
+            reader = OpenColumnReaderAt(rg_reader, col, this->pages, seek, first_row, reader_first_row);
+            typed = dynamic_cast<TypedColumnReader<DType>*>(reader.get());
+            if (!typed) throw std::runtime_error("Couldn't open typed column reader");
+            next_row = this->pages ? this->pages->streamRow(reader_first_row) : reader_first_row;
+
+            max_def_level = typed->descr()->max_definition_level();
+            use_dictionary = reader->GetExposedEncoding() == parquet::ExposedEncoding::DICTIONARY;
+            batch_size = std::min(kIndexBatchSize, std::max<int64_t>(chunk_rows, 1));
+            def_levels.resize(batch_size);
+        }
+
+        void read(const RowRange* ranges, size_t num_ranges, uint64_t* lens) override {
+            StreamRanges rows(ranges, num_ranges, pages.get());
+            while (!rows.done()) {
+                // Un long intervalle entre deux plages est saute ; un court est decode avec le batch
+                const int64_t first_row = rows.first();
+                if (first_row - next_row >= batch_size) {
+                    next_row += typed->Skip(first_row - next_row);
+                }
+
+                const int64_t levels_read = readBatch(std::min(batch_size, rows.end() - next_row));
+                if (levels_read <= 0) break;
+
+                rows.take(next_row, next_row + levels_read, [&](int64_t offset, int64_t count) {
+                    writeLengths(offset, count, lens);
+                    lens += count;
+                });
+                next_row += levels_read;
+            }
+
+            // truncated column chunk: missing values are empty
+            std::fill(lens, lens + rows.remaining(), 1);
+        }
+
+    private:
+        std::shared_ptr<const SkippedPages> pages;
+        int64_t chunk_rows;
+
+        std::shared_ptr<parquet::ColumnReader> reader;
+        TypedColumnReader<DType>* typed = nullptr;
+        int16_t max_def_level = 0;
+
+        int64_t next_row = 0;           // ligne de la prochaine valeur a decoder, sans les pages sautees
+        int64_t batch_size = 0;
+
+        // Column chunk encode par dictionnaire : la taille de chaque entree n'est calculee qu'une fois
+        bool use_dictionary = false;
+        bool batch_indices = false;     // le batch courant contient des indices et non des valeurs
+        DictionaryText<T> dictionary;
+
+        // batch courant
+        std::vector<T> values;
+        std::vector<int32_t> indices;
+        std::vector<int16_t> def_levels;
+        std::vector<int32_t> value_pos;  // indice de la valeur de chaque ligne, -1 si nulle
+        bool dense_batch = false;        // batch sans valeur nulle
+
+        int64_t readBatch(int64_t batch) {
+            int64_t values_read = 0;
+            int64_t levels_read;
+            batch_indices = use_dictionary;
+            if (batch_indices) {
+                const T* dict = nullptr;
+                int32_t dict_len = 0;
+                indices.resize(batch_size);
+                levels_read = typed->ReadBatchWithDictionary(batch, def_levels.data(), nullptr, indices.data(),
+                                                             &values_read, &dict, &dict_len);
+                if (levels_read > 0) {
+                    dictionary.reset(dict, dict_len);
+                    use_dictionary = static_cast<int64_t>(dict_len) * kMinDictionaryReuse <= chunk_rows;
+                }
+            }
+            else {
+                values.resize(batch_size);
+                levels_read = typed->ReadBatch(batch, def_levels.data(), nullptr, values.data(), &values_read);
+            }
+
+            dense_batch = values_read == levels_read;
+            if (!dense_batch && levels_read > 0) {
+                value_pos.resize(batch_size);
+                int32_t v = 0;
+                for (int64_t i = 0; i < levels_read; i++) {
+                    value_pos[i] = def_levels[i] == max_def_level ? v++ : -1;
+                }
+            }
+            return levels_read;
+        }
+
+        // Tailles rendues (separateur inclus) des lignes [first, first + count) du batch
+        void writeLengths(int64_t first, int64_t count, uint64_t* lens) {
+            if (dense_batch && !batch_indices) {
+                for (int64_t i = 0; i < count; i++) {
+                    lens[i] = FormattedLength(values[first + i]) + 1;
+                }
+                return;
+            }
+
+            // nulls are rendered as empty values
+            for (int64_t i = 0; i < count; i++) {
+                const int64_t v = dense_batch ? first + i : value_pos[first + i];
+                if (v < 0) {
+                    lens[i] = 1;
+                }
+                else {
+                    lens[i] = (batch_indices ? dictionary.length(indices[v]) : FormattedLength(values[v])) + 1;
+                }
+            }
+        }
+};
+
+template <typename DType>
+bool RenderConstantColumn(const parquet::Statistics& stats, std::string& text) {
+    using T = typename DType::c_type;
+    auto* typed = dynamic_cast<const parquet::TypedStatistics<DType>*>(&stats);
+    if (!typed) return false;
+
+    const T& value = typed->min();
+    text.resize(FormattedLength(value));
+    FormatValue(value, reinterpret_cast<uint8_t*>(text.data()));
+    return true;
+}
+
+} // namespace
+
+bool RenderConstantColumn(const parquet::RowGroupMetaData& rg_metadata, int col, std::string& text) {
+    auto chunk = rg_metadata.ColumnChunk(col);
+    const parquet::ColumnDescriptor* descr = rg_metadata.schema()->Column(col);
+    if (descr->max_repetition_level() > 0) return false;
+
+    std::shared_ptr<parquet::Statistics> stats = chunk->statistics();
+    if (!stats || !stats->HasMinMax() || !stats->HasNullCount() || stats->null_count() != 0) return false;
+    if (chunk->num_values() != rg_metadata.num_rows()) return false;
+
+    if (stats->EncodeMin() != stats->EncodeMax()) return false;
+
+    // Un min ou max tronque ne designe pas une valeur effective
+    if (stats->is_min_value_exact() == false || stats->is_max_value_exact() == false) return false;
+
+    // Pas de flottants : les statistiques ignorent les NaN, min == max n'exclut pas une valeur NaN
+    switch (descr->physical_type())
+    {
+    case Type::INT32: return RenderConstantColumn<parquet::Int32Type>(*stats, text);
+    case Type::INT64: return RenderConstantColumn<parquet::Int64Type>(*stats, text);
+    case Type::BYTE_ARRAY: return RenderConstantColumn<parquet::ByteArrayType>(*stats, text);
+    default:
+        return false;
+    }
+}
+
+std::shared_ptr<const SkippedPages> SkippedPages::Make(const parquet::OffsetIndex& offset_index, int64_t num_rows, const RowRange* ranges, size_t num_ranges) {
+    const std::vector<parquet::PageLocation>& locations = offset_index.page_locations();
+    if (locations.empty()) return nullptr;
+
+    auto pages = std::make_shared<SkippedPages>();
+    pages->first_rows.resize(locations.size());
+    pages->skipped_rows.resize(locations.size());
+    pages->skipped.resize(locations.size());
+
+    // Parcours simultane des pages et des plages, toutes deux triees
+    bool any_skipped = false;
+    int64_t skipped_rows = 0;
+    size_t r = 0;
+    for (size_t page = 0; page < locations.size(); page++) {
+        const int64_t page_first = locations[page].first_row_index;
+        const int64_t page_end = page + 1 < locations.size() ? locations[page + 1].first_row_index : num_rows;
+
+        while (r < num_ranges && ranges[r].first_row + ranges[r].num_rows <= page_first) r++;
+        const bool skip = r == num_ranges || ranges[r].first_row >= page_end;
+
+        pages->first_rows[page] = page_first;
+        pages->skipped_rows[page] = skipped_rows;
+        pages->skipped[page] = skip;
+        if (skip) {
+            skipped_rows += page_end - page_first;
+            any_skipped = true;
+        }
+    }
+    return any_skipped ? pages : nullptr;
+}
+
+int64_t SkippedPages::streamRow(int64_t row) const {
+    auto it = std::upper_bound(first_rows.begin(), first_rows.end(), row);
+    if (it == first_rows.begin()) return row;
+    return row - skipped_rows[std::distance(first_rows.begin(), it) - 1];
+}
+
+std::shared_ptr<parquet::ColumnReader> OpenColumnReader(parquet::RowGroupReader& rg_reader, int col, std::shared_ptr<const SkippedPages> pages) {
+    if (!pages) {
+        return rg_reader.ColumnWithExposeEncoding(col, parquet::ExposedEncoding::DICTIONARY);
+    }
+
+    // Le filtre est appele une fois par page de donnees, dans l'ordre du column chunk.
+    // Le dictionnaire n'est pas expose par un reader construit sur son propre PageReader.
+    std::unique_ptr<parquet::PageReader> page_reader = rg_reader.GetColumnPageReader(col);
+    page_reader->set_data_page_filter([pages, page = size_t(0)](const parquet::DataPageStats&) mutable {
+        return pages->skip(page++);
+    });
+    return parquet::ColumnReader::Make(rg_reader.metadata()->schema()->Column(col), std::move(page_reader));
+}
+
+int64_t ColumnChunkStart(const parquet::ColumnChunkMetaData& chunk) {
+    int64_t start = chunk.data_page_offset();
+    if (chunk.has_dictionary_page() && chunk.dictionary_page_offset() > 0) {
+        start = std::min(start, chunk.dictionary_page_offset());
+    }
+    return start;
+}
+
+namespace {
+
+// Le dictionnaire est unique : les pages encodees par dictionnaire precedent celles ecrites apres
+// le repli de l'ecrivain sur l'encodage PLAIN, qui n'en dependent pas
+bool PageUsesDictionary(const parquet::ColumnChunkMetaData& chunk, size_t page) {
+    const std::vector<parquet::PageEncodingStats>& encoding_stats = chunk.encoding_stats();
+    if (encoding_stats.empty()) return true;
+
+    int64_t dictionary_pages = 0;
+    for (const parquet::PageEncodingStats& stats : encoding_stats) {
+        const bool data_page = stats.page_type == parquet::PageType::DATA_PAGE || stats.page_type == parquet::PageType::DATA_PAGE_V2;
+        const bool dictionary_encoding = stats.encoding == parquet::Encoding::PLAIN_DICTIONARY || stats.encoding == parquet::Encoding::RLE_DICTIONARY;
+        if (data_page && dictionary_encoding) {
+            dictionary_pages += stats.count;
+        }
+    }
+    return static_cast<int64_t>(page) < dictionary_pages;
+}
+
+// Pages lues a partir de la page page de l'index des offsets : le reader lit le dictionnaire,
+// qui precede la premiere page de donnees, s'il est utilise, puis la fin du column chunk
+std::shared_ptr<parquet::ColumnReader> OpenColumnReaderAtPage(parquet::RowGroupReader& rg_reader,
+                                                              int col,
+                                                              std::shared_ptr<const SkippedPages> pages,
+                                                              const PageSeek& seek,
+                                                              size_t page) {
+    const std::vector<parquet::PageLocation>& locations = seek.offset_index->page_locations();
+    auto chunk = rg_reader.metadata()->ColumnChunk(col);
+    const parquet::ColumnDescriptor* descr = rg_reader.metadata()->schema()->Column(col);
+
+    const int64_t chunk_start = ColumnChunkStart(*chunk);
+    const int64_t chunk_end = chunk_start + chunk->total_compressed_size();
+    if (locations[page].offset >= chunk_end) throw std::runtime_error("Invalid offset index");
+
+    PARQUET_ASSIGN_OR_THROW(std::shared_ptr<arrow::Buffer> data, seek.file->ReadAt(locations[page].offset, chunk_end - locations[page].offset));
+    if (locations[0].offset > chunk_start && PageUsesDictionary(*chunk, page)) {
+        PARQUET_ASSIGN_OR_THROW(std::shared_ptr<arrow::Buffer> dictionary, seek.file->ReadAt(chunk_start, locations[0].offset - chunk_start));
+        PARQUET_ASSIGN_OR_THROW(data, arrow::ConcatenateBuffers({ dictionary, data }));
+    }
+
+    // Colonne non repetee : une valeur par ligne
+    const int64_t num_values = chunk->num_values() - locations[page].first_row_index;
+    auto stream = std::make_shared<arrow::io::BufferReader>(std::move(data));
+#if ARROW_VERSION_MAJOR >= 25
+    std::unique_ptr<parquet::PageReader> page_reader = parquet::PageReader::Open(std::move(stream), num_values, chunk->compression(),
+                                                                                 parquet::default_reader_properties(), *descr);
+#else
+    std::unique_ptr<parquet::PageReader> page_reader = parquet::PageReader::Open(std::move(stream), num_values, chunk->compression(),
+                                                                                 parquet::default_reader_properties());
+#endif
+    if (pages) {
+        page_reader->set_data_page_filter([pages, page](const parquet::DataPageStats&) mutable {
+            return pages->skip(page++);
+        });
+    }
+    return parquet::ColumnReader::Make(descr, std::move(page_reader));
+}
+
+} // namespace
+
+std::shared_ptr<parquet::ColumnReader> OpenColumnReaderAt(parquet::RowGroupReader& rg_reader, int col, std::shared_ptr<const SkippedPages> pages, const PageSeek& seek, int64_t row, int64_t& first_row) {
+    first_row = 0;
+    auto chunk = rg_reader.metadata()->ColumnChunk(col);
+    const parquet::ColumnDescriptor* descr = rg_reader.metadata()->schema()->Column(col);
+    if (row <= 0 || !seek.file || descr->max_repetition_level() > 0 || chunk->crypto_metadata()) {
+        return OpenColumnReader(rg_reader, col, std::move(pages));
+    }
+
+    if (seek.offset_index) {
+        const std::vector<parquet::PageLocation>& locations = seek.offset_index->page_locations();
+        auto it = std::upper_bound(locations.begin(), locations.end(), row,
+            [](int64_t r, const parquet::PageLocation& location) { return r < location.first_row_index; });
+        if (it == locations.begin() || --it == locations.begin()) {
+            return OpenColumnReader(rg_reader, col, std::move(pages));
+        }
+        first_row = it->first_row_index;
+        return OpenColumnReaderAtPage(rg_reader, col, std::move(pages), seek, static_cast<size_t>(std::distance(locations.begin(), it)));
+    }
+    if (pages) {
+        return OpenColumnReader(rg_reader, col, std::move(pages));
+    }
+
+    // Sans index des offsets, les pages precedant la ligne sont reperees par le nombre de lignes
+    // de leur en-tete, puis ecartees par le filtre des pages
+    auto skipped_rows = std::make_shared<int64_t>(0);
+    std::unique_ptr<parquet::PageReader> page_reader = rg_reader.GetColumnPageReader(col);
+    page_reader->set_data_page_filter([skipped_rows, row, reached = false](const parquet::DataPageStats& stats) mutable {
+        const int64_t page_rows = stats.num_rows ? *stats.num_rows : stats.num_values;
+        if (!reached && *skipped_rows + page_rows <= row) {
+            *skipped_rows += page_rows;
+            return true;
+        }
+        reached = true;
+        return false;
+    });
+    std::shared_ptr<parquet::ColumnReader> reader = parquet::ColumnReader::Make(descr, std::move(page_reader));
+
+    // Chargement de la premiere page lue, les pages precedentes etant sautees
+    reader->HasNext();
+    first_row = *skipped_rows;
+    return reader;
+}
+
+std::unique_ptr<ColumnCursor> ColumnCursor::Make(std::shared_ptr<parquet::RowGroupReader> rg_reader, int col, std::shared_ptr<const SkippedPages> pages, PageSeek seek) {
+    switch (rg_reader->metadata()->schema()->Column(col)->physical_type())
+    {
+    case Type::INT32:
+        return std::make_unique<TypedColumnCursor<parquet::Int32Type>>(std::move(rg_reader), col, std::move(pages), std::move(seek));
+    case Type::INT64:
+        return std::make_unique<TypedColumnCursor<parquet::Int64Type>>(std::move(rg_reader), col, std::move(pages), std::move(seek));
+    case Type::FLOAT:
+        return std::make_unique<TypedColumnCursor<parquet::FloatType>>(std::move(rg_reader), col, std::move(pages), std::move(seek));
+    case Type::DOUBLE:
+        return std::make_unique<TypedColumnCursor<parquet::DoubleType>>(std::move(rg_reader), col, std::move(pages), std::move(seek));
+    case Type::BYTE_ARRAY:
+        return std::make_unique<TypedColumnCursor<parquet::ByteArrayType>>(std::move(rg_reader), col, std::move(pages), std::move(seek));
+    default:
+        throw std::runtime_error("Unsupported type");
+    }
+}
+
+std::unique_ptr<ColumnLengths> ColumnLengths::Make(parquet::RowGroupReader& rg_reader, int col, std::shared_ptr<const SkippedPages> pages, const PageSeek& seek, int64_t first_row) {
+    std::string constant_text;
+    if (RenderConstantColumn(*rg_reader.metadata(), col, constant_text)) {
+        return std::make_unique<ConstantColumnLengths>(constant_text.size() + 1);
+    }
+
+    switch (rg_reader.metadata()->schema()->Column(col)->physical_type())
+    {
+    case Type::INT32:
+        return std::make_unique<TypedColumnLengths<parquet::Int32Type>>(rg_reader, col, std::move(pages), seek, first_row);
+    case Type::INT64:
+        return std::make_unique<TypedColumnLengths<parquet::Int64Type>>(rg_reader, col, std::move(pages), seek, first_row);
+    case Type::FLOAT:
+        return std::make_unique<TypedColumnLengths<parquet::FloatType>>(rg_reader, col, std::move(pages), seek, first_row);
+    case Type::DOUBLE:
+        return std::make_unique<TypedColumnLengths<parquet::DoubleType>>(rg_reader, col, std::move(pages), seek, first_row);
+    case Type::BYTE_ARRAY:
+        return std::make_unique<TypedColumnLengths<parquet::ByteArrayType>>(rg_reader, col, std::move(pages), seek, first_row);
+    default:
+        throw std::runtime_error("Unsupported type");
+    }
+}
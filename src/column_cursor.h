@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+
+#include <arrow/io/interfaces.h>
+#include <parquet/api/reader.h>
+#include <parquet/page_index.h>
+
+// Plage de lignes consecutives d'un row group retenues par un filtre
+struct RowRange {
+    int64_t first_row;      // premiere ligne de la plage dans le row group
+    int64_t num_rows;
+    int64_t row;            // rang de first_row parmi les lignes retenues du row group
+};
+
+// Pages de donnees d'un column chunk ne contenant aucune ligne retenue : elles ne sont ni
+// decompressees ni decodees, et le reader ne voit que les lignes des autres pages
+class SkippedPages {
+
+    public:
+        // Pages sans ligne des plages (triees) d'apres l'index des offsets du column chunk.
+        // Returns nullptr if every page holds a selected row.
+        static std::shared_ptr<const SkippedPages> Make(const parquet::OffsetIndex& offset_index,
+                                                        int64_t num_rows,
+                                                        const RowRange* ranges,
+                                                        size_t num_ranges);
+
+        bool skip(size_t page) const { return page < skipped.size() && skipped[page]; }
+
+        // Rang de la ligne dans les lignes lues, la ligne n'etant pas dans une page sautee
+        int64_t streamRow(int64_t row) const;
+
+    private:
+        std::vector<int64_t> first_rows;        // premiere ligne de chaque page
+        std::vector<int64_t> skipped_rows;      // lignes des pages sautees avant chaque page
+        std::vector<bool> skipped;
+};
+
+// Lignes de plages triees, parcourues dans l'ordre du flux lu par un reader (sans les pages sautees).
+// Le flux est decode par fenetres de lignes consecutives, dont seules les lignes des plages sont retenues.
+class StreamRanges {
+
+    public:
+        StreamRanges(const RowRange* ranges, size_t num_ranges, const SkippedPages* pages)
+            : ranges(ranges), num_ranges(num_ranges), pages(pages) {
+            while (num_ranges > 0 && ranges[num_ranges - 1].num_rows == 0) num_ranges--;
+            this->num_ranges = num_ranges;
+            for (size_t r = 0; r < num_ranges; r++) remaining_rows += ranges[r].num_rows;
+            if (num_ranges > 0) {
+                stream_end = streamRow(ranges[num_ranges - 1].first_row) + ranges[num_ranges - 1].num_rows;
+                enter(0);
+            }
+        }
+
+        bool done() const { return r == num_ranges; }
+
+        // Premiere ligne du flux non encore retenue, et fin de la derniere plage
+        int64_t first() const { return range_start + in_range; }
+        int64_t end() const { return stream_end; }
+
+        int64_t remaining() const { return remaining_rows; }
+
+        // Retient les lignes des plages de la fenetre [window_first, window_end) du flux, qui doit
+        // commencer au plus tard a first() : emit(position dans la fenetre, nombre de lignes)
+        template <typename Emit>
+        void take(int64_t window_first, int64_t window_end, Emit&& emit) {
+            if (!done() && first() < window_first) throw std::runtime_error("Rows must be read in order");
+            while (!done() && first() < window_end) {
+                const int64_t count = std::min(ranges[r].num_rows - in_range, window_end - first());
+                emit(first() - window_first, count);
+                in_range += count;
+                remaining_rows -= count;
+                if (in_range == ranges[r].num_rows) enter(r + 1);
+            }
+        }
+
+    private:
+        const RowRange* ranges;
+        size_t num_ranges;
+        const SkippedPages* pages;
+
+        size_t r = 0;                   // plage courante
+        int64_t range_start = 0;        // debut de la plage courante dans le flux
+        int64_t in_range = 0;           // lignes deja retenues de la plage courante
+        int64_t stream_end = 0;
+        int64_t remaining_rows = 0;
+
+        int64_t streamRow(int64_t row) const { return pages ? pages->streamRow(row) : row; }
+
+        void enter(size_t range) {
+            for (r = range; r < num_ranges && ranges[r].num_rows == 0; r++) {}
+            in_range = 0;
+            if (r < num_ranges) range_start = streamRow(ranges[r].first_row);
+        }
+};
+
+// Ouvre une colonne du row group en exposant son dictionnaire, ou sans ses pages sautees
+std::shared_ptr<parquet::ColumnReader> OpenColumnReader(parquet::RowGroupReader& rg_reader,
+                                                        int col,
+                                                        std::shared_ptr<const SkippedPages> pages);
+
+// Debut du column chunk dans le fichier : page du dictionnaire, ou premiere page de donnees
+int64_t ColumnChunkStart(const parquet::ColumnChunkMetaData& chunk);
+
+// Acces direct aux pages de donnees d'un column chunk (sans fichier : lecture depuis la premiere page)
+struct PageSeek {
+    std::shared_ptr<arrow::io::RandomAccessFile> file;      // fichier parquet du row group
+    std::shared_ptr<parquet::OffsetIndex> offset_index;     // nullptr : pages reperees par leur en-tete
+};
+
+// Ouvre une colonne du row group a la page de donnees contenant la ligne row, qui ne doit pas etre
+// dans une page sautee. Avec l'index des offsets, seules cette page et les suivantes (et le dictionnaire)
+// sont lues dans le fichier ; sinon les pages precedentes sont lues mais ni decompressees ni decodees.
+// first_row recoit la ligne du row group de la premiere valeur lue par le reader.
+std::shared_ptr<parquet::ColumnReader> OpenColumnReaderAt(parquet::RowGroupReader& rg_reader,
+                                                          int col,
+                                                          std::shared_ptr<const SkippedPages> pages,
+                                                          const PageSeek& seek,
+                                                          int64_t row,
+                                                          int64_t& first_row);
+
+// Lecteur persistant d'une colonne d'un row group.
+// Le ColumnReader reste positionne juste apres la derniere valeur decodee : une lecture
+// sequentielle continue le decodage la ou il s'est arrete. La colonne est ouverte a la premiere
+// lecture, et reouverte lors d'un retour en arriere, a la page de la ligne demandee.
+// Une colonne entierement encodee par dictionnaire est lue sous forme d'indices, chaque entree
+// du dictionnaire n'etant rendue qu'une fois ; une colonne constante n'est pas decodee.
+class ColumnCursor {
+
+    public:
+        virtual ~ColumnCursor() = default;
+
+        // Ecrit dans out la valeur rendue de la ligne row du row group (sans separateur).
+        // out doit pouvoir contenir la taille rendue donnee par l'index. Une valeur nulle est rendue vide.
+        // Returns the number of bytes written, -1 if the row cannot be decoded
+        virtual int64_t writeValue(int64_t row, uint8_t* out) = 0;
+
+        // Les lignes des pages sautees ne peuvent pas etre lues
+        static std::unique_ptr<ColumnCursor> Make(std::shared_ptr<parquet::RowGroupReader> rg_reader,
+                                                  int col,
+                                                  std::shared_ptr<const SkippedPages> pages = nullptr,
+                                                  PageSeek seek = PageSeek());
+};
+
+// Calcul par batchs des tailles rendues d'une colonne d'un row group, pour la construction de l'index.
+// Les plages de lignes sont lues dans l'ordre, les lignes entre deux plages etant sautees sans etre decodees.
+class ColumnLengths {
+
+    public:
+        virtual ~ColumnLengths() = default;
+
+        // Ecrit dans lens la taille rendue (separateur inclus) de chaque ligne des plages,
+        // qui doivent suivre celles des appels precedents
+        virtual void read(const RowRange* ranges, size_t num_ranges, uint64_t* lens) = 0;
+
+        // Les plages lues commencent a la ligne first_row ou apres
+        static std::unique_ptr<ColumnLengths> Make(parquet::RowGroupReader& rg_reader,
+                                                   int col,
+                                                   std::shared_ptr<const SkippedPages> pages = nullptr,
+                                                   const PageSeek& seek = PageSeek(),
+                                                   int64_t first_row = 0);
+};
+
+// Rendu (sans separateur) de la valeur d'une colonne constante du row group : d'apres les
+// statistiques du column chunk, toutes les lignes ont la meme valeur non nulle (min == max).
+// Returns false if the column is not known to be constant.
+bool RenderConstantColumn(const parquet::RowGroupMetaData& rg_metadata, int col, std::string& text);
@@ -0,0 +1,543 @@
+// Banc de mesure du driver : genere un fichier parquet synthetique (ou lit un fichier existant), puis mesure
+// l'ouverture, driver_getFileSize, la lecture sequentielle par driver_fread et les lectures apres un
+// driver_fseek aleatoire. Les resultats sont ecrits en JSON pour comparer les executions.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/util/compression.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/file_reader.h>
+#include <parquet/properties.h>
+
+#ifdef _WIN32
+#define environ _environ
+#else
+extern char** environ;
+#endif
+
+#include "bench_report.h"
+#include "khiopsdriver_file_parquet.h"
+
+namespace {
+
+const char* kUsage =
+    "Usage: parquet_reader_bench [options]\n"
+    "Generation (ignored with --input):\n"
+    "  --output PATH          generated file (default: parquet_reader_bench.parquet in the temp directory)\n"
+    "  --rows N               number of rows (default 1000000)\n"
+    "  --row-group-rows N     rows per row group (default 100000)\n"
+    "  --page-size BYTES      data page size (default 1048576)\n"
+    "  --codec NAME           uncompressed, snappy, gzip, zstd, lz4, brotli (default snappy)\n"
+    "  --plain                plain encoding (dictionary encoding otherwise)\n"
+    "  --schema MIX           type:count list of int32, int64, float, double, string\n"
+    "                         (default int64:2,double:2,string:2,int32:1,float:1)\n"
+    "  --null-ratio R         ratio of null values (default 0.05)\n"
+    "  --string-length DIST   fixed:N, uniform:MIN:MAX or exponential:MEAN (default uniform:4:24)\n"
+    "  --cardinality N        distinct values per column, 0 for random values (default 0)\n"
+    "  --seed N               random seed (default 42)\n"
+    "  --keep                 keep the generated file\n"
+    "Measures:\n"
+    "  --input PATH           existing parquet file or directory to measure\n"
+    "  --repeat N             opens and driver_getFileSize calls (default 10)\n"
+    "  --buffer-sizes LIST    driver_fread buffer sizes (default 4096,65536,1048576)\n"
+    "  --seeks N              random driver_fseek + driver_fread (default 1000)\n"
+    "  --seek-read BYTES      bytes read after each seek (default 4096)\n"
+    "  --json PATH            results file (default: standard output)\n"
+    "The KHIOPS_PARQUET_* environment variables apply to the driver and are reported in the results.\n"
+    "Peak RSS includes the generation: generate with --keep, then measure with --input for the reader alone.\n";
+
+struct BenchOptions {
+    std::string output;
+    int64_t rows = 1000000;
+    int64_t row_group_rows = 100000;
+    int64_t page_size = 1 << 20;
+    std::string codec = "snappy";
+    bool dictionary = true;
+    std::string schema = "int64:2,double:2,string:2,int32:1,float:1";
+    double null_ratio = 0.05;
+    std::string string_length = "uniform:4:24";
+    int64_t cardinality = 0;
+    uint64_t seed = 42;
+    bool keep = false;
+
+    std::string input;
+    int repeat = 10;
+    std::vector<size_t> buffer_sizes = { 4096, 65536, 1048576 };
+    int seeks = 1000;
+    size_t seek_read = 4096;
+    std::string json;
+};
+
+void Check(const arrow::Status& status, const std::string& what) {
+    if (!status.ok()) throw std::runtime_error(what + ": " + status.ToString());
+}
+
+std::vector<std::string> Split(const std::string& text, char separator) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator)) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+int64_t ParseInteger(const std::string& text, const std::string& option) {
+    char* end = nullptr;
+    const long long value = std::strtoll(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || value < 0) throw std::runtime_error("Invalid value for " + option + ": " + text);
+    return value;
+}
+
+BenchOptions ParseOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            std::cout << kUsage;
+            std::exit(0);
+        }
+        if (arg == "--plain") {
+            options.dictionary = false;
+            continue;
+        }
+        if (arg == "--keep") {
+            options.keep = true;
+            continue;
+        }
+        if (i + 1 >= argc) throw std::runtime_error("Missing value for " + arg);
+        const std::string value = argv[++i];
+
+        if (arg == "--output") options.output = value;
+        else if (arg == "--rows") options.rows = ParseInteger(value, arg);
+        else if (arg == "--row-group-rows") options.row_group_rows = std::max<int64_t>(1, ParseInteger(value, arg));
+        else if (arg == "--page-size") options.page_size = std::max<int64_t>(1, ParseInteger(value, arg));
+        else if (arg == "--codec") options.codec = value;
+        else if (arg == "--schema") options.schema = value;
+        else if (arg == "--null-ratio") options.null_ratio = std::atof(value.c_str());
+        else if (arg == "--string-length") options.string_length = value;
+        else if (arg == "--cardinality") options.cardinality = ParseInteger(value, arg);
+        else if (arg == "--seed") options.seed = static_cast<uint64_t>(ParseInteger(value, arg));
+        else if (arg == "--input") options.input = value;
+        else if (arg == "--repeat") options.repeat = static_cast<int>(std::max<int64_t>(1, ParseInteger(value, arg)));
+        else if (arg == "--seeks") options.seeks = static_cast<int>(ParseInteger(value, arg));
+        else if (arg == "--seek-read") options.seek_read = static_cast<size_t>(std::max<int64_t>(1, ParseInteger(value, arg)));
+        else if (arg == "--json") options.json = value;
+        else if (arg == "--buffer-sizes") {
+            options.buffer_sizes.clear();
+            for (const std::string& size : Split(value, ',')) {
+                options.buffer_sizes.push_back(static_cast<size_t>(std::max<int64_t>(1, ParseInteger(size, arg))));
+            }
+        }
+        else throw std::runtime_error("Unknown option: " + arg + "\n" + kUsage);
+    }
+
+    if (options.null_ratio < 0 || options.null_ratio > 1) throw std::runtime_error("Invalid value for --null-ratio");
+    if (options.output.empty()) {
+        options.output = (std::filesystem::temp_directory_path() / "parquet_reader_bench.parquet").string();
+    }
+    return options;
+}
+
+// Generation du fichier synthetique
+
+// Distribution des longueurs de chaines : fixed:N, uniform:MIN:MAX ou exponential:MEAN
+class StringLengths {
+
+    public:
+        explicit StringLengths(const std::string& spec) {
+            const std::vector<std::string> parts = Split(spec, ':');
+            if (parts.size() == 2 && parts[0] == "fixed") {
+                min = max = ParseInteger(parts[1], "--string-length");
+            }
+            else if (parts.size() == 3 && parts[0] == "uniform") {
+                min = ParseInteger(parts[1], "--string-length");
+                max = ParseInteger(parts[2], "--string-length");
+                if (max < min) throw std::runtime_error("Invalid value for --string-length: " + spec);
+            }
+            else if (parts.size() == 2 && parts[0] == "exponential") {
+                mean = static_cast<double>(ParseInteger(parts[1], "--string-length"));
+            }
+            else {
+                throw std::runtime_error("Invalid value for --string-length: " + spec);
+            }
+        }
+
+        size_t operator()(std::mt19937_64& rng) const {
+            if (mean > 0) {
+                // Queue de distribution bornee, pour garder des lignes de taille raisonnable
+                const double length = std::exponential_distribution<double>(1.0 / mean)(rng);
+                return static_cast<size_t>(std::min(length, 16 * mean));
+            }
+            return static_cast<size_t>(std::uniform_int_distribution<int64_t>(min, max)(rng));
+        }
+
+    private:
+        int64_t min = 0;
+        int64_t max = 0;
+        double mean = 0;
+};
+
+std::shared_ptr<arrow::Schema> MakeSchema(const std::string& mix) {
+    arrow::FieldVector fields;
+    for (const std::string& entry : Split(mix, ',')) {
+        const std::vector<std::string> parts = Split(entry, ':');
+        if (parts.empty() || parts.size() > 2) throw std::runtime_error("Invalid value for --schema: " + mix);
+        const int64_t count = parts.size() == 2 ? ParseInteger(parts[1], "--schema") : 1;
+
+        std::shared_ptr<arrow::DataType> type;
+        if (parts[0] == "int32") type = arrow::int32();
+        else if (parts[0] == "int64") type = arrow::int64();
+        else if (parts[0] == "float") type = arrow::float32();
+        else if (parts[0] == "double") type = arrow::float64();
+        else if (parts[0] == "string") type = arrow::utf8();
+        else throw std::runtime_error("Unsupported column type in --schema: " + parts[0]);
+
+        for (int64_t c = 0; c < count; c++) {
+            fields.push_back(arrow::field(parts[0] + "_" + std::to_string(fields.size()), type));
+        }
+    }
+    if (fields.empty()) throw std::runtime_error("Invalid value for --schema: " + mix);
+    return arrow::schema(fields);
+}
+
+std::string RandomString(size_t length, std::mt19937_64& rng) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 -_";
+    std::uniform_int_distribution<size_t> letter(0, sizeof(alphabet) - 2);
+    std::string text(length, ' ');
+    for (char& c : text) {
+        c = alphabet[letter(rng)];
+    }
+    return text;
+}
+
+// Valeurs d'une colonne pour un row group ; avec une cardinalite, les valeurs sont tirees parmi autant
+// de valeurs distinctes (les chaines d'un vocabulaire fixe de la colonne)
+class ColumnGenerator {
+
+    public:
+        ColumnGenerator(const std::shared_ptr<arrow::DataType>& type, const BenchOptions& options, const StringLengths& lengths, std::mt19937_64& rng)
+            : type(type), null_ratio(options.null_ratio), cardinality(options.cardinality), lengths(lengths) {
+            if (type->id() == arrow::Type::STRING) {
+                for (int64_t v = 0; v < cardinality; v++) {
+                    vocabulary.push_back(RandomString(lengths(rng), rng));
+                }
+            }
+        }
+
+        std::shared_ptr<arrow::Array> generate(int64_t rows, std::mt19937_64& rng) const {
+            switch (type->id()) {
+            case arrow::Type::INT32: return generateNumbers<arrow::Int32Builder>(rows, rng);
+            case arrow::Type::INT64: return generateNumbers<arrow::Int64Builder>(rows, rng);
+            case arrow::Type::FLOAT: return generateNumbers<arrow::FloatBuilder>(rows, rng);
+            case arrow::Type::DOUBLE: return generateNumbers<arrow::DoubleBuilder>(rows, rng);
+            default: return generateStrings(rows, rng);
+            }
+        }
+
+    private:
+        std::shared_ptr<arrow::DataType> type;
+        double null_ratio;
+        int64_t cardinality;
+        const StringLengths& lengths;
+        std::vector<std::string> vocabulary;
+
+        template <typename Builder>
+        std::shared_ptr<arrow::Array> generateNumbers(int64_t rows, std::mt19937_64& rng) const {
+            using T = typename Builder::value_type;
+            std::bernoulli_distribution is_null(null_ratio);
+            std::uniform_int_distribution<int64_t> value(0, cardinality > 0 ? cardinality - 1 : 1000000000);
+
+            Builder builder;
+            Check(builder.Reserve(rows), "Reserve");
+            for (int64_t row = 0; row < rows; row++) {
+                if (is_null(rng)) {
+                    builder.UnsafeAppendNull();
+                }
+                else if (std::is_floating_point<T>::value) {
+                    builder.UnsafeAppend(static_cast<T>(value(rng)) / static_cast<T>(1000));
+                }
+                else {
+                    builder.UnsafeAppend(static_cast<T>(value(rng) - (cardinality > 0 ? 0 : 500000000)));
+                }
+            }
+            std::shared_ptr<arrow::Array> array;
+            Check(builder.Finish(&array), "Finish");
+            return array;
+        }
+
+        std::shared_ptr<arrow::Array> generateStrings(int64_t rows, std::mt19937_64& rng) const {
+            std::bernoulli_distribution is_null(null_ratio);
+            std::uniform_int_distribution<size_t> word(0, vocabulary.empty() ? 0 : vocabulary.size() - 1);
+
+            arrow::StringBuilder builder;
+            Check(builder.Reserve(rows), "Reserve");
+            for (int64_t row = 0; row < rows; row++) {
+                if (is_null(rng)) {
+                    Check(builder.AppendNull(), "Append");
+                }
+                else if (!vocabulary.empty()) {
+                    Check(builder.Append(vocabulary[word(rng)]), "Append");
+                }
+                else {
+                    Check(builder.Append(RandomString(lengths(rng), rng)), "Append");
+                }
+            }
+            std::shared_ptr<arrow::Array> array;
+            Check(builder.Finish(&array), "Finish");
+            return array;
+        }
+};
+
+void GenerateFile(const BenchOptions& options) {
+    const arrow::Result<arrow::Compression::type> codec = arrow::util::Codec::GetCompressionType(options.codec);
+    if (!codec.ok()) throw std::runtime_error("Unknown codec: " + options.codec);
+    if (!arrow::util::Codec::IsAvailable(*codec)) throw std::runtime_error("Codec not available in this build: " + options.codec);
+
+    parquet::WriterProperties::Builder properties;
+    properties.compression(*codec)
+        ->data_pagesize(options.page_size)
+        ->max_row_group_length(options.row_group_rows);
+    if (options.dictionary) properties.enable_dictionary();
+    else properties.disable_dictionary();
+
+    const std::shared_ptr<arrow::Schema> schema = MakeSchema(options.schema);
+    const StringLengths lengths(options.string_length);
+    std::mt19937_64 rng(options.seed);
+
+    std::vector<ColumnGenerator> generators;
+    for (const std::shared_ptr<arrow::Field>& field : schema->fields()) {
+        generators.emplace_back(field->type(), options, lengths, rng);
+    }
+
+    arrow::Result<std::shared_ptr<arrow::io::FileOutputStream>> sink = arrow::io::FileOutputStream::Open(options.output);
+    Check(sink.status(), "Unable to create " + options.output);
+    arrow::Result<std::unique_ptr<parquet::arrow::FileWriter>> writer =
+        parquet::arrow::FileWriter::Open(*schema, arrow::default_memory_pool(), *sink, properties.build());
+    Check(writer.status(), "Unable to write " + options.output);
+
+    // Un row group genere a la fois
+    for (int64_t first_row = 0; first_row < options.rows; first_row += options.row_group_rows) {
+        const int64_t rows = std::min(options.row_group_rows, options.rows - first_row);
+        arrow::ArrayVector columns;
+        for (const ColumnGenerator& generator : generators) {
+            columns.push_back(generator.generate(rows, rng));
+        }
+        Check((*writer)->WriteTable(*arrow::Table::Make(schema, columns, rows), rows), "Unable to write " + options.output);
+    }
+    Check((*writer)->Close(), "Unable to write " + options.output);
+    Check((*sink)->Close(), "Unable to write " + options.output);
+}
+
+// Mesures
+
+// URI du driver pour un chemin absolu : parquet://C/path sous windows (le driver remet le ':' apres la
+// lettre de lecteur), parquet:///path sous linux (le chemin garde son '/' initial)
+std::string DriverUri(const std::string& path) {
+    std::string uri_path = std::filesystem::absolute(path).generic_string();
+    if (uri_path.size() >= 2 && uri_path[1] == ':') uri_path.erase(1, 1);
+    return std::string(driver_getScheme()) + "://" + uri_path;
+}
+
+void* OpenOrThrow(const std::string& uri) {
+    void* stream = driver_fopen(uri.c_str(), 'r');
+    if (!stream) throw std::runtime_error("driver_fopen failed on " + uri + ": " + driver_getlasterror());
+    return stream;
+}
+
+std::string MeasureOpen(const std::string& uri, int repeat) {
+    // La premiere ouverture lit le footer et indexe le fichier, les suivantes retrouvent l'index
+    std::vector<double> reopens;
+    double first = 0;
+    for (int i = 0; i <= repeat; i++) {
+        const Clock::time_point start = Clock::now();
+        void* stream = OpenOrThrow(uri);
+        const double elapsed = ElapsedUs(start);
+        driver_fclose(stream);
+        if (i == 0) first = elapsed;
+        else reopens.push_back(elapsed);
+    }
+    return JsonObject().add("first_us", first).addJson("reopen", LatencyStats(reopens)).add("peak_rss_bytes", PeakRssBytes()).str();
+}
+
+std::string MeasureFileSize(const std::string& uri, int repeat, long long& logical_size) {
+    std::vector<double> samples;
+    for (int i = 0; i < repeat; i++) {
+        const Clock::time_point start = Clock::now();
+        logical_size = driver_getFileSize(uri.c_str());
+        samples.push_back(ElapsedUs(start));
+        if (logical_size < 0) throw std::runtime_error("driver_getFileSize failed on " + uri);
+    }
+    return LatencyStats(samples);
+}
+
+std::string MeasureSequential(const std::string& uri, const std::vector<size_t>& buffer_sizes, long long logical_size) {
+    std::string runs = "[";
+    for (size_t size : buffer_sizes) {
+        std::vector<char> buffer(size);
+        void* stream = OpenOrThrow(uri);
+
+        const Clock::time_point start = Clock::now();
+        long long total = 0;
+        uint64_t calls = 0;
+        long long read;
+        while ((read = driver_fread(buffer.data(), 1, size, stream)) > 0) {
+            total += read;
+            calls++;
+        }
+        const double elapsed = ElapsedUs(start);
+        driver_fclose(stream);
+
+        if (read < 0 || total != logical_size) {
+            throw std::runtime_error("driver_fread read " + std::to_string(total) + " bytes of " + std::to_string(logical_size));
+        }
+        const double seconds = elapsed / 1e6;
+        runs += (runs.size() > 1 ? ", " : "") + JsonObject()
+            .add("buffer_bytes", static_cast<uint64_t>(size))
+            .add("seconds", seconds)
+            .add("mb_per_s", static_cast<double>(total) / 1e6 / seconds)
+            .add("call_us", elapsed / static_cast<double>(std::max<uint64_t>(1, calls)))
+            .add("peak_rss_bytes", PeakRssBytes())
+            .str();
+    }
+    return runs + "]";
+}
+
+std::string MeasureSeeks(const std::string& uri, int seeks, size_t read_size, long long logical_size, uint64_t seed) {
+    std::vector<char> buffer(read_size);
+    std::vector<double> samples;
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<long long> offset(0, std::max(0LL, logical_size - 1));
+
+    void* stream = OpenOrThrow(uri);
+    for (int i = 0; i < seeks && logical_size > 0; i++) {
+        const long long target = offset(rng);
+        const Clock::time_point start = Clock::now();
+        const int seeked = driver_fseek(stream, target, SEEK_SET);
+        const long long read = driver_fread(buffer.data(), 1, read_size, stream);
+        samples.push_back(ElapsedUs(start));
+        if (seeked != 0 || read < 0) {
+            driver_fclose(stream);
+            throw std::runtime_error("driver_fseek/driver_fread failed at " + std::to_string(target));
+        }
+    }
+    driver_fclose(stream);
+    return JsonObject()
+        .add("read_bytes", static_cast<uint64_t>(read_size))
+        .addJson("latency", LatencyStats(samples))
+        .add("peak_rss_bytes", PeakRssBytes())
+        .str();
+}
+
+std::string FileInfo(const std::string& path, const std::string& uri, long long logical_size) {
+    JsonObject info;
+    info.add("path", path).add("uri", uri).add("logical_bytes", static_cast<int64_t>(logical_size));
+
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(path, ec)) {
+        std::unique_ptr<parquet::ParquetFileReader> reader = parquet::ParquetFileReader::OpenFile(path, false);
+        const std::shared_ptr<parquet::FileMetaData> metadata = reader->metadata();
+        info.add("disk_bytes", static_cast<uint64_t>(std::filesystem::file_size(path)))
+            .add("rows", static_cast<int64_t>(metadata->num_rows()))
+            .add("row_groups", static_cast<int64_t>(metadata->num_row_groups()))
+            .add("columns", static_cast<int64_t>(metadata->num_columns()));
+    }
+    return info.str();
+}
+
+std::string DriverEnvironment() {
+    JsonObject environment;
+    for (char** variable = environ; *variable; variable++) {
+        const std::string entry = *variable;
+        const size_t eq = entry.find('=');
+        if (entry.compare(0, 15, "KHIOPS_PARQUET_") == 0 && eq != std::string::npos) {
+            environment.add(entry.substr(0, eq), entry.substr(eq + 1));
+        }
+    }
+    return environment.str();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const BenchOptions options = ParseOptions(argc, argv);
+        const bool generate = options.input.empty();
+        const std::string path = generate ? options.output : options.input;
+
+        JsonObject results;
+        results.addJson("driver", JsonObject().add("name", driver_getDriverName()).add("version", driver_getVersion()).str())
+            .addJson("environment", DriverEnvironment());
+
+        if (generate) {
+            const Clock::time_point start = Clock::now();
+            GenerateFile(options);
+            results.addJson("generator", JsonObject()
+                .add("rows", options.rows)
+                .add("row_group_rows", options.row_group_rows)
+                .add("page_size", options.page_size)
+                .add("codec", options.codec)
+                .add("encoding", options.dictionary ? "dictionary" : "plain")
+                .add("schema", options.schema)
+                .add("null_ratio", options.null_ratio)
+                .add("string_length", options.string_length)
+                .add("cardinality", options.cardinality)
+                .add("seed", options.seed)
+                .add("seconds", ElapsedUs(start) / 1e6)
+                .add("peak_rss_bytes", PeakRssBytes())
+                .str());
+        }
+
+        driver_connect();
+        const std::string uri = DriverUri(path);
+        const std::string open = MeasureOpen(uri, options.repeat);
+        long long logical_size = 0;
+        const std::string file_size = MeasureFileSize(uri, options.repeat, logical_size);
+        const std::string sequential = MeasureSequential(uri, options.buffer_sizes, logical_size);
+        const std::string seeks = MeasureSeeks(uri, options.seeks, options.seek_read, logical_size, options.seed);
+        driver_disconnect();
+
+        results.addJson("file", FileInfo(path, uri, logical_size))
+            .addJson("open", open)
+            .addJson("get_file_size", file_size)
+            .addJson("sequential_read", sequential)
+            .addJson("random_seek_read", seeks)
+            .add("peak_rss_bytes", PeakRssBytes());
+
+        if (generate && !options.keep) {
+            std::error_code ec;
+            std::filesystem::remove(options.output, ec);
+        }
+
+        const std::string json = results.str(true) + "\n";
+        if (options.json.empty()) {
+            std::cout << json;
+        }
+        else {
+            std::ofstream out(options.json);
+            out << json;
+            if (!out) throw std::runtime_error("Unable to write " + options.json);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "parquet_reader_bench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -2,8 +2,20 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
-
-#include "parquet_file.h"
+#include <thread>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <filesystem>
+
+#include <arrow/io/file.h>
+#include <parquet/column_writer.h>
+#include <parquet/file_writer.h>
+
+#include "parquet_dataset.h"
+#include "value_format.h"
 #include "khiopsdriver_file_parquet.h"
 
 #define VERBOSE false
@@ -14,7 +26,7 @@ int test_driver_fopen_errors() {
 	int failed = 0;
 
 	for (const char* arg : args) {
-		ParquetFile* mf = (ParquetFile*)driver_fopen(arg, 'r');
+		ParquetDataset* mf = (ParquetDataset*)driver_fopen(arg, 'r');
 		if (mf != nullptr) {
 			failed++;
 		}
@@ -46,7 +58,7 @@ int test_driver_fread_errors() {
 	std::string path = "parquet://C/Users/Public/khiops_data/samples/AccidentsMedium/Places.parquet";
 
 	// opening file
-	ParquetFile* mf = (ParquetFile*)driver_fopen(path.c_str(), 'r');
+	ParquetDataset* mf = (ParquetDataset*)driver_fopen(path.c_str(), 'r');
 	if (mf == nullptr) {
 		throw std::runtime_error("driver_fopen error during driver_fread errors.");
 	}
@@ -90,7 +102,7 @@ int test_driver_fread() {
 	std::string path = "parquet://C/Users/Public/khiops_data/samples/AccidentsMedium/Places.parquet";
 
 	// opening file
-	ParquetFile* mf = (ParquetFile*)driver_fopen(path.c_str(), 'r');
+	ParquetDataset* mf = (ParquetDataset*)driver_fopen(path.c_str(), 'r');
 	if (mf == nullptr) {
 		throw std::runtime_error("driver_fopen error during driver_fread.");
 	}
@@ -127,7 +139,7 @@ int test_driver_fread() {
 int test_driver_fread_all_file() {
 	std::string path = "parquet://C/Users/Public/khiops_data/samples/AccidentsMedium/Places.parquet";
 
-	ParquetFile* mf = (ParquetFile*)driver_fopen(path.c_str(), 'r');
+	ParquetDataset* mf = (ParquetDataset*)driver_fopen(path.c_str(), 'r');
 	if (mf == nullptr) {
 		throw std::runtime_error("driver_fopen error during driver_fread all file test.");
 	}
@@ -178,7 +190,7 @@ int test_driver_fread_whole_file_in_one_read() {
 	std::string path = "parquet://C/Users/KXFJ3896/Documents/parquet_reader/data/toto.parquet";
 
 	// opening file
-	ParquetFile* mf = (ParquetFile*)driver_fopen(path.c_str(), 'r');
+	ParquetDataset* mf = (ParquetDataset*)driver_fopen(path.c_str(), 'r');
 	if (mf == nullptr) {
 		throw std::runtime_error("driver_fopen error during driver_fread tests.");
 	}
@@ -229,7 +241,7 @@ int test_driver_fseek_errors() {
 
 	std::string path = "parquet://C/Users/KXFJ3896/Documents/parquet_reader/data/toto.parquet";
 
-	ParquetFile* mf = (ParquetFile*)driver_fopen(path.c_str(), 'r');
+	ParquetDataset* mf = (ParquetDataset*)driver_fopen(path.c_str(), 'r');
 	if (mf == nullptr) {
 		throw std::runtime_error("driver_fopen error during driver_fseek errors.");
 	}
@@ -290,7 +302,7 @@ int test_driver_fseek_random(int times = 20) {
 
 	std::string path = "parquet://C/Users/Public/khiops_data/samples/AccidentsMedium/Places.parquet";
 
-	ParquetFile* mf = (ParquetFile*)driver_fopen(path.c_str(), 'r');
+	ParquetDataset* mf = (ParquetDataset*)driver_fopen(path.c_str(), 'r');
 	if (mf == nullptr) {
 		throw std::runtime_error("driver_fopen error during driver_fseek errors.");
 	}
@@ -317,11 +329,119 @@ int test_driver_fseek_random(int times = 20) {
 	return failed;
 }
 
+// concurrent calls to driver_pread on one stream, compared to the content read by driver_fread
+int test_driver_pread(int threads = 4, int times = 200) {
+	std::string path = "parquet://C/Users/Public/khiops_data/samples/AccidentsMedium/Places.parquet";
+
+	ParquetDataset* mf = (ParquetDataset*)driver_fopen(path.c_str(), 'r');
+	if (mf == nullptr) {
+		throw std::runtime_error("driver_fopen error during driver_pread tests.");
+	}
+
+	size_t file_size = driver_getFileSize(path.c_str());
+	std::vector<char> content(file_size);
+	if (driver_fread(content.data(), 1, file_size, mf) != (long long int)file_size) {
+		throw std::runtime_error("driver_fread error during driver_pread tests.");
+	}
+
+	std::atomic<int> failed{ 0 };
+	std::vector<std::thread> readers;
+	for (int t = 0; t < threads; t++) {
+		readers.emplace_back([&, t]() {
+			// rand() is not thread-safe: one generator per thread
+			std::mt19937 rng(t);
+			std::uniform_int_distribution<size_t> offsets(0, file_size);
+			std::vector<char> buffer(1000);
+			for (int iter = 0; iter < times; iter++) {
+				size_t offset = offsets(rng);
+				size_t len = 1 + (size_t)(t * 7919 + iter * 104729) % buffer.size();
+				size_t exp = std::min(len, file_size - offset);
+
+				long long int code = driver_pread(mf, offset, buffer.data(), len);
+				if (code != (long long int)exp || memcmp(buffer.data(), content.data() + offset, exp) != 0) {
+					std::cout << "driver_pread test: invalid read of " << len << " bytes at " << offset << std::endl;
+					failed++;
+				}
+			}
+		});
+	}
+	for (auto& reader : readers) {
+		reader.join();
+	}
+
+	if (mf->pos != file_size) {
+		std::cout << "driver_pread test: the position of the stream has changed" << std::endl;
+		failed++;
+	}
+
+	if (driver_pread(mf, file_size + 1, content.data(), 1) != -1) {
+		std::cout << "driver_pread test: offset after the end of file doesn't return -1" << std::endl;
+		failed++;
+	}
+
+	if (driver_fclose(mf) == -1) {
+		throw std::runtime_error("driver_fclose error during driver_pread tests.");
+	}
+	return failed;
+}
+
+// split points must be line starts, in the order of the targets
+int test_driver_split_points(int count = 100) {
+	std::string path = "parquet://C/Users/Public/khiops_data/samples/AccidentsMedium/Places.parquet";
+
+	ParquetDataset* mf = (ParquetDataset*)driver_fopen(path.c_str(), 'r');
+	if (mf == nullptr) {
+		throw std::runtime_error("driver_fopen error during driver_getSplitPoints tests.");
+	}
+
+	size_t file_size = driver_getFileSize(path.c_str());
+	std::vector<char> content(file_size);
+	if (driver_fread(content.data(), 1, file_size, mf) != (long long int)file_size) {
+		throw std::runtime_error("driver_fread error during driver_getSplitPoints tests.");
+	}
+
+	int failed = 0;
+	std::vector<long long> targets(count);
+	std::vector<long long> split_points(count);
+	for (int i = 0; i < count; i++) {
+		targets[i] = (long long)(file_size * i / (count - 1));
+	}
+	for (long long tolerance : { 0LL, 10000LL }) {
+		if (driver_getSplitPoints(mf, targets.data(), split_points.data(), count, tolerance) != 0) {
+			throw std::runtime_error("driver_getSplitPoints error during driver_getSplitPoints tests.");
+		}
+		for (int i = 0; i < count; i++) {
+			long long split = split_points[i];
+			bool line_start = split == 0 || split == (long long)file_size || (split > 0 && split < (long long)file_size && content[split - 1] == '\n');
+			if (!line_start || (i > 0 && split < split_points[i - 1])) {
+				std::cout << "driver_getSplitPoints test: invalid split point " << split << " for " << targets[i] << std::endl;
+				failed++;
+			}
+		}
+	}
+
+	// line 0 is the header, line 1 the first row
+	long long first_line = (long long)(std::find(content.begin(), content.end(), '\n') - content.begin()) + 1;
+	if (driver_getLineOffset(mf, 0) != 0 || driver_getLineOffset(mf, 1) != first_line) {
+		std::cout << "driver_getLineOffset test: invalid offset of the first lines" << std::endl;
+		failed++;
+	}
+	if (driver_getLineOffset(mf, -1) != -1) {
+		std::cout << "driver_getLineOffset test: negative line doesn't return -1" << std::endl;
+		failed++;
+	}
+
+	if (driver_fclose(mf) == -1) {
+		throw std::runtime_error("driver_fclose error during driver_getSplitPoints tests.");
+	}
+	return failed;
+}
+
 // crossing the file from begin to end using driver_fseek
 int test_driver_fseek_all_file() {
 	std::string path = "parquet://C/Users/Public/khiops_data/samples/AccidentsMedium/Places.parquet";
 
-	ParquetFile* mf = (ParquetFile*)driver_fopen(path.c_str(), 'r');
+	ParquetDataset* mf = (ParquetDataset*)driver_fopen(path.c_str(), 'r');
 	if (mf == nullptr) {
 		throw std::runtime_error("driver_fopen error during driver_fseek all file test.");
 	}
@@ -365,7 +485,7 @@ int test_driver_fseek_all_file() {
 int test_driver_fseek_all_file_reverse() {
 	std::string path = "parquet://C/Users/Public/khiops_data/samples/AccidentsMedium/Places.parquet";
 
-	ParquetFile* mf = (ParquetFile*)driver_fopen(path.c_str(), 'r');
+	ParquetDataset* mf = (ParquetDataset*)driver_fopen(path.c_str(), 'r');
 	if (mf == nullptr) {
 		throw std::runtime_error("driver_fopen error during driver_fseek all file test.");
 	}
@@ -414,6 +534,24 @@ int test_driver_fseek_all_file_reverse() {
 	return 0;
 }
 
+// whole content of a file read with driver_fread, throws if it cannot be opened
+std::string driver_read_all(const std::string& uri) {
+	void* stream = driver_fopen(uri.c_str(), 'r');
+	if (stream == nullptr) {
+		throw std::runtime_error("driver_fopen error on " + uri);
+	}
+	std::string content;
+	std::vector<char> buffer(1000);
+	long long code;
+	while ((code = driver_fread(buffer.data(), 1, buffer.size(), stream)) > 0)
+		content.append(buffer.data(), (size_t)code);
+	driver_fclose(stream);
+	if (code == -1) {
+		throw std::runtime_error("driver_fread error on " + uri);
+	}
+	return content;
+}
+
 void print_file_size_error(const char* path, int exp, int got) {
 	std::cout << "test getFileSize error: invalid result for (" << path << "): exp (" << exp << ") | got (" << got << ")" << std::endl;
 }
@@ -429,6 +567,7 @@ int test_file_size() {
 		failed++;
 	}
 
+	// no floating point column: the size doesn't depend on the number formatting
 	path = "parquet://C/Users/KXFJ3896/Documents/parquet_reader/data/toto.parquet";
 	code = driver_getFileSize(path);
 	exp = 140;
@@ -453,9 +592,11 @@ int test_file_size() {
 		failed++;
 	}*/
 
+	// floating point columns: the former size (5037442) was that of the fixed "%f" formatting, the size
+	// must now be the length of the text read with the driver (pinned sizes: see test_float_file_size)
 	path = "parquet://C/Users/Public/khiops_data/samples/AccidentsMedium/Places.parquet";
 	code = driver_getFileSize(path);
-	exp = 5037442;
+	exp = (int)driver_read_all(path).size();
 	if (code != exp) {
 		print_file_size_error(path, exp, code);
 		failed++;
@@ -464,6 +605,492 @@ int test_file_size() {
 	return failed;
 }
 
+template <typename T>
+int check_format(T value, const std::string& exp) {
+	uint8_t text[kMaxNumberLength];
+	size_t len = FormatValue(value, text);
+	std::string got((const char*)text, len);
+	if (got != exp || FormattedLength(value) != len) {
+		std::cout << "value format test error: exp (" << exp << ") | got (" << got << ") length " << FormattedLength(value) << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// number formatting: integers written two digits at a time, floating point values in their shortest
+// text that reads back to the same value
+int test_value_format() {
+	int failed = 0;
+
+	failed += check_format((int64_t)0, "0");
+	failed += check_format((int64_t)7, "7");
+	failed += check_format((int64_t)10, "10");
+	failed += check_format((int64_t)99, "99");
+	failed += check_format((int64_t)100, "100");
+	failed += check_format((int64_t)-1, "-1");
+	failed += check_format((int64_t)1234567890123, "1234567890123");
+	failed += check_format(std::numeric_limits<int64_t>::max(), "9223372036854775807");
+	failed += check_format(std::numeric_limits<int64_t>::min(), "-9223372036854775808");
+	failed += check_format(std::numeric_limits<int32_t>::min(), "-2147483648");
+
+	failed += check_format(0.1, "0.1");
+	failed += check_format(3.0, "3");
+	failed += check_format(-0.0, "-0");
+	failed += check_format(123456789.0, "123456789");
+	failed += check_format(1e20, "1e+20");
+	failed += check_format(1e-7, "1e-07");
+	failed += check_format(std::numeric_limits<double>::max(), "1.7976931348623157e+308");
+	failed += check_format(std::numeric_limits<double>::denorm_min(), "5e-324");
+	failed += check_format(0.1f, "0.1");
+	failed += check_format(-2.5f, "-2.5");
+	failed += check_format(std::numeric_limits<float>::max(), "3.4028235e+38");
+
+	// shortest round-trip
+	for (double value : { 1.0 / 3.0, 2.0 / 3.0, 1e-300 / 7.0, 6.02214076e23, 0.30000000000000004 }) {
+		uint8_t text[kMaxNumberLength + 1];
+		size_t len = FormatValue(value, text);
+		text[len] = '\0';
+		if (std::strtod((const char*)text, nullptr) != value) {
+			std::cout << "value format test error: " << (const char*)text << " doesn't read back to the same value" << std::endl;
+			failed++;
+		}
+	}
+	return failed;
+}
+
+// test files written by the tests, in the temp directory
+std::string test_data_path(const std::string& name) {
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / "khiops_parquet_driver_test";
+	std::filesystem::create_directories(dir);
+	return (dir / name).generic_string();
+}
+
+// driver URI of a local absolute path: parquet://C/path on windows, parquet:///path on linux
+std::string driver_uri(const std::string& local_path) {
+	std::string path = local_path;
+	if (path.size() >= 2 && path[1] == ':')
+		path.erase(1, 1);
+	return "parquet://" + path;
+}
+
+// required column of a test file: int64 and string values, or double values also written as FLOAT
+struct test_column {
+	std::string name;
+	parquet::Type::type type;
+	std::vector<int64_t> integers;
+	std::vector<double> numbers;
+	std::vector<std::string> strings;
+
+	size_t size() const { return type == parquet::Type::INT64 ? integers.size() : type == parquet::Type::BYTE_ARRAY ? strings.size() : numbers.size(); }
+};
+
+// writes the columns in row groups of row_group_rows rows, with pages of a few rows and the page index,
+// so that the filters can prune row groups and pages
+void write_test_file(const std::string& path, const std::vector<test_column>& columns, int64_t row_group_rows) {
+	parquet::schema::NodeVector fields;
+	for (const test_column& column : columns) {
+		parquet::ConvertedType::type converted = column.type == parquet::Type::BYTE_ARRAY ? parquet::ConvertedType::UTF8 : parquet::ConvertedType::NONE;
+		fields.push_back(parquet::schema::PrimitiveNode::Make(column.name, parquet::Repetition::REQUIRED, column.type, converted));
+	}
+	auto schema = std::static_pointer_cast<parquet::schema::GroupNode>(parquet::schema::GroupNode::Make("schema", parquet::Repetition::REQUIRED, fields));
+
+	std::shared_ptr<parquet::WriterProperties> properties = parquet::WriterProperties::Builder()
+		.disable_dictionary()
+		->data_pagesize(64)
+		->write_batch_size(8)
+		->enable_write_page_index()
+		->build();
+	std::shared_ptr<arrow::io::FileOutputStream> out = arrow::io::FileOutputStream::Open(path).ValueOrDie();
+	std::unique_ptr<parquet::ParquetFileWriter> writer = parquet::ParquetFileWriter::Open(out, schema, properties);
+
+	int64_t rows = (int64_t)columns[0].size();
+	for (int64_t first = 0; first < rows; first += row_group_rows) {
+		int64_t count = std::min(row_group_rows, rows - first);
+		parquet::RowGroupWriter* rg_writer = writer->AppendRowGroup();
+		for (const test_column& column : columns) {
+			parquet::ColumnWriter* column_writer = rg_writer->NextColumn();
+			if (column.type == parquet::Type::INT64) {
+				static_cast<parquet::Int64Writer*>(column_writer)->WriteBatch(count, nullptr, nullptr, column.integers.data() + first);
+			}
+			else if (column.type == parquet::Type::DOUBLE) {
+				static_cast<parquet::DoubleWriter*>(column_writer)->WriteBatch(count, nullptr, nullptr, column.numbers.data() + first);
+			}
+			else if (column.type == parquet::Type::FLOAT) {
+				std::vector<float> values(column.numbers.begin() + first, column.numbers.begin() + first + count);
+				static_cast<parquet::FloatWriter*>(column_writer)->WriteBatch(count, nullptr, nullptr, values.data());
+			}
+			else {
+				std::vector<parquet::ByteArray> values;
+				for (int64_t i = first; i < first + count; i++)
+					values.emplace_back((uint32_t)column.strings[i].size(), (const uint8_t*)column.strings[i].data());
+				static_cast<parquet::ByteArrayWriter*>(column_writer)->WriteBatch(count, nullptr, nullptr, values.data());
+			}
+		}
+	}
+	writer->Close();
+	if (!out->Close().ok()) {
+		throw std::runtime_error("unable to write test file " + path);
+	}
+}
+
+// expected driver output for the given rows of the columns (tab separator, no quoted values)
+std::string expected_text(const std::vector<const test_column*>& columns, const std::vector<int64_t>& rows) {
+	std::string text;
+	for (size_t col = 0; col < columns.size(); col++)
+		text += columns[col]->name + (col + 1 < columns.size() ? "\t" : "\n");
+	for (int64_t row : rows) {
+		for (size_t col = 0; col < columns.size(); col++) {
+			const test_column& column = *columns[col];
+			uint8_t number[kMaxNumberLength];
+			if (column.type == parquet::Type::INT64)
+				text.append((const char*)number, FormatValue(column.integers[row], number));
+			else if (column.type == parquet::Type::DOUBLE)
+				text.append((const char*)number, FormatValue(column.numbers[row], number));
+			else if (column.type == parquet::Type::FLOAT)
+				text.append((const char*)number, FormatValue((float)column.numbers[row], number));
+			else
+				text += column.strings[row];
+			text += col + 1 < columns.size() ? '\t' : '\n';
+		}
+	}
+	return text;
+}
+
+// compares the content and the size of a file read with the driver to the expected text
+int check_driver_content(const char* test, const std::string& uri, const std::string& exp) {
+	int failed = 0;
+	std::string got = driver_read_all(uri);
+	if (got != exp) {
+		std::cout << test << " test error: invalid content for " << uri << " (exp: \"" << exp.substr(0, 200) << "\", got: \"" << got.substr(0, 200) << "\")" << std::endl;
+		failed++;
+	}
+	long long size = driver_getFileSize(uri.c_str());
+	if (size != (long long)exp.size()) {
+		print_file_size_error(uri.c_str(), (int)exp.size(), (int)size);
+		failed++;
+	}
+	return failed;
+}
+
+// min == max in the statistics of a floating point column doesn't make it constant: NaN values are
+// left out of the statistics
+int test_constant_column_with_nan() {
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	test_column d = { "d", parquet::Type::DOUBLE, {}, { 5.0, nan, 5.0, 5.0 }, {} };
+	test_column f = { "f", parquet::Type::FLOAT, {}, { nan, 5.0, 5.0, 5.0 }, {} };
+	test_column i = { "i", parquet::Type::INT64, { 7, 7, 7, 7 }, {}, {} };
+
+	std::string path = test_data_path("nan.parquet");
+	write_test_file(path, { d, f, i }, 4);
+	return check_driver_content("constant column with NaN", driver_uri(path), expected_text({ &d, &f, &i }, { 0, 1, 2, 3 }));
+}
+
+// floating point values in their shortest round-trip text, fixed or exponent notation whichever is
+// shorter (fixed on ties): the expected text and its size are pinned, counted by hand
+int test_float_file_size() {
+	test_column d = { "d", parquet::Type::DOUBLE, {}, { 0.1, -1.5, 1e20, 2.5e-8, 123456.789, 1.0 / 3, 1e15, 0.001 }, {} };
+	test_column f = { "f", parquet::Type::FLOAT, {}, { 0.1, 3.14159, 1e10, 16777216.0, 0.5, -2.0, 0.0001, 100.0 }, {} };
+	const std::string exp =
+		"d\tf\n"
+		"0.1\t0.1\n"
+		"-1.5\t3.14159\n"
+		"1e+20\t1e+10\n"
+		"2.5e-08\t16777216\n"
+		"123456.789\t0.5\n"
+		"0.3333333333333333\t-2\n"
+		"1e+15\t1e-04\n"
+		"0.001\t100\n";
+
+	std::string path = test_data_path("floats.parquet");
+	write_test_file(path, { d, f }, 8);
+	std::string uri = driver_uri(path);
+	int failed = 0;
+	long long size = driver_getFileSize(uri.c_str());
+	if (size != 113) {
+		print_file_size_error(uri.c_str(), 113, (int)size);
+		failed++;
+	}
+	return failed + check_driver_content("float file size", uri, exp);
+}
+
+// columns of the projection and filter tests: id, id % 3, a double and a string
+std::vector<test_column> sample_columns(int64_t rows) {
+	test_column id = { "id", parquet::Type::INT64, {}, {}, {} };
+	test_column k = { "k", parquet::Type::INT64, {}, {}, {} };
+	test_column v = { "v", parquet::Type::DOUBLE, {}, {}, {} };
+	test_column name = { "name", parquet::Type::BYTE_ARRAY, {}, {}, {} };
+	for (int64_t row = 0; row < rows; row++) {
+		id.integers.push_back(row);
+		k.integers.push_back(row % 3);
+		v.numbers.push_back(row * 0.25);
+		name.strings.push_back("n" + std::to_string(row));
+	}
+	return { id, k, v, name };
+}
+
+std::vector<int64_t> all_rows(int64_t rows) {
+	std::vector<int64_t> selected(rows);
+	for (int64_t row = 0; row < rows; row++)
+		selected[row] = row;
+	return selected;
+}
+
+// columns=... : only the listed columns, in the order of the list
+int test_projected_columns() {
+	std::vector<test_column> columns = sample_columns(300);
+	std::string path = test_data_path("sample.parquet");
+	write_test_file(path, columns, 100);
+	std::string uri = driver_uri(path);
+
+	int failed = 0;
+	failed += check_driver_content("projected columns", uri + "?columns=name,id", expected_text({ &columns[3], &columns[0] }, all_rows(300)));
+	failed += check_driver_content("projected columns", uri + "?columns=v", expected_text({ &columns[2] }, all_rows(300)));
+
+	for (const char* options : { "?columns=id,unknown", "?columns=", "?columns=id,,k", "?unknown=1" }) {
+		void* stream = driver_fopen((uri + options).c_str(), 'r');
+		if (stream != nullptr) {
+			std::cout << "projected columns test error: invalid URI options " << options << " accepted" << std::endl;
+			driver_fclose(stream);
+			failed++;
+		}
+	}
+	return failed;
+}
+
+// rows of sample_columns satisfying a predicate
+template <typename Predicate>
+std::vector<int64_t> selected_rows(int64_t rows, Predicate predicate) {
+	std::vector<int64_t> selected;
+	for (int64_t row = 0; row < rows; row++)
+		if (predicate(row))
+			selected.push_back(row);
+	return selected;
+}
+
+// filters excluding whole row groups (100 rows each) from their statistics, and invalid filters
+int test_filter_row_groups() {
+	std::vector<test_column> columns = sample_columns(300);
+	std::string path = test_data_path("sample_filter.parquet");
+	write_test_file(path, columns, 100);
+	std::string uri = driver_uri(path);
+	std::vector<const test_column*> all = { &columns[0], &columns[1], &columns[2], &columns[3] };
+
+	int failed = 0;
+	failed += check_driver_content("row group filter", uri + "?filter=id >= 250", expected_text(all, selected_rows(300, [](int64_t row) { return row >= 250; })));
+	failed += check_driver_content("row group filter", uri + "?filter=id IN (5, 260)", expected_text(all, { 5, 260 }));
+	failed += check_driver_content("row group filter", uri + "?filter=name = 'n150'", expected_text(all, { 150 }));
+	failed += check_driver_content("row group filter", uri + "?filter=v > 1000", expected_text(all, {}));
+	failed += check_driver_content("row group filter", uri + "?columns=name&filter=id < 120 AND id > 95",
+		expected_text({ &columns[3] }, selected_rows(300, [](int64_t row) { return row < 120 && row > 95; })));
+
+	for (const char* filter : { "id >", "unknown = 1", "id = 'a'", "id = 1 OR k = 2", "name = 'n1" }) {
+		std::string invalid = uri + "?filter=" + filter;
+		void* stream = driver_fopen(invalid.c_str(), 'r');
+		if (stream != nullptr) {
+			std::cout << "row group filter test error: invalid filter \"" << filter << "\" accepted" << std::endl;
+			driver_fclose(stream);
+			failed++;
+		}
+		if (driver_getFileSize(invalid.c_str()) != -1) {
+			std::cout << "row group filter test error: size of invalid filter \"" << filter << "\" doesn't return -1" << std::endl;
+			failed++;
+		}
+	}
+	return failed;
+}
+
+// filters keeping part of the rows of the pages (8 rows each): the predicates are evaluated row by row,
+// and the filtered content can be read at any offset
+int test_filter_partial_pages() {
+	std::vector<test_column> columns = sample_columns(300);
+	std::string path = test_data_path("sample_pages.parquet");
+	write_test_file(path, columns, 100);
+	std::string uri = driver_uri(path);
+	std::vector<const test_column*> all = { &columns[0], &columns[1], &columns[2], &columns[3] };
+
+	int failed = 0;
+	failed += check_driver_content("partial pages filter", uri + "?filter=k = 1", expected_text(all, selected_rows(300, [](int64_t row) { return row % 3 == 1; })));
+	failed += check_driver_content("partial pages filter", uri + "?filter=id > 3 AND id < 13", expected_text(all, selected_rows(300, [](int64_t row) { return row > 3 && row < 13; })));
+	failed += check_driver_content("partial pages filter", uri + "?filter=k <> 0 AND v >= 20 AND id <= 205",
+		expected_text(all, selected_rows(300, [](int64_t row) { return row % 3 != 0 && row * 0.25 >= 20 && row <= 205; })));
+
+	std::string filtered = uri + "?columns=id,name&filter=k IN (0, 2) AND id >= 90";
+	std::string exp = expected_text({ &columns[0], &columns[3] }, selected_rows(300, [](int64_t row) { return row % 3 != 1 && row >= 90; }));
+	failed += check_driver_content("partial pages filter", filtered, exp);
+
+	void* stream = driver_fopen(filtered.c_str(), 'r');
+	if (stream == nullptr) {
+		throw std::runtime_error("driver_fopen error during partial pages filter test.");
+	}
+	char buffer[50];
+	for (size_t offset = 0; offset < exp.size(); offset += 37) {
+		size_t len = std::min(sizeof(buffer), exp.size() - offset);
+		long long code = driver_fseek(stream, (long long)offset, SEEK_SET) == 0 ? driver_fread(buffer, 1, sizeof(buffer), stream) : -1;
+		if (code != (long long)len || exp.compare(offset, len, buffer, len) != 0) {
+			std::cout << "partial pages filter test error: invalid read at offset " << offset << std::endl;
+			failed++;
+		}
+	}
+	driver_fclose(stream);
+	return failed;
+}
+
+// rows first to last - 1 of the columns
+std::vector<test_column> slice_columns(const std::vector<test_column>& columns, int64_t first, int64_t last) {
+	std::vector<test_column> slice;
+	for (const test_column& column : columns) {
+		test_column part = { column.name, column.type, {}, {}, {} };
+		if (column.type == parquet::Type::INT64)
+			part.integers.assign(column.integers.begin() + first, column.integers.begin() + last);
+		else if (column.type == parquet::Type::BYTE_ARRAY)
+			part.strings.assign(column.strings.begin() + first, column.strings.begin() + last);
+		else
+			part.numbers.assign(column.numbers.begin() + first, column.numbers.begin() + last);
+		slice.push_back(part);
+	}
+	return slice;
+}
+
+// empty test directory
+std::string test_data_dir(const std::string& name) {
+	std::string dir = test_data_path(name);
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	return dir;
+}
+
+// file of a test dataset, its directories created if needed
+std::string test_dataset_file(const std::string& dir, const std::string& relative_path) {
+	std::filesystem::path path = std::filesystem::path(dir) / relative_path;
+	std::filesystem::create_directories(path.parent_path());
+	return path.generic_string();
+}
+
+// Hive partitioned directory read as one file: members in path order under one header, partition keys
+// rendered as columns after those of the files (%XX sequences decoded, __HIVE_DEFAULT_PARTITION__ as null),
+// empty member files, and entries starting with '_' or '.' skipped
+int test_dataset_read() {
+	std::string dir = test_data_dir("dataset");
+	std::vector<test_column> columns = sample_columns(50);
+
+	// members in path order: partition directory, first and last row of the member
+	struct member { const char* directory; int64_t first; int64_t last; };
+	std::vector<member> members = {
+		{ "year=2023/city=Paris", 0, 20 },
+		{ "year=2023/city=a%2Fb", 20, 35 },
+		{ "year=2024/city=Lyon", 35, 35 },
+		{ "year=2024/city=__HIVE_DEFAULT_PARTITION__", 35, 50 },
+	};
+	std::vector<std::string> years = { "2023", "2023", "2024", "2024" };
+	std::vector<std::string> cities = { "Paris", "a/b", "Lyon", "" };
+
+	std::string exp;
+	for (size_t m = 0; m < members.size(); m++) {
+		std::vector<test_column> part = slice_columns(columns, members[m].first, members[m].last);
+		write_test_file(test_dataset_file(dir, std::string(members[m].directory) + "/part-0.parquet"), part, 8);
+
+		// partition values rendered as string columns, a null value as an empty one
+		int64_t rows = members[m].last - members[m].first;
+		test_column year = { "year", parquet::Type::BYTE_ARRAY, {}, {}, std::vector<std::string>(rows, years[m]) };
+		test_column city = { "city", parquet::Type::BYTE_ARRAY, {}, {}, std::vector<std::string>(rows, cities[m]) };
+		std::string text = expected_text({ &part[0], &part[1], &part[2], &part[3], &year, &city }, all_rows(rows));
+		exp += m == 0 ? text : text.substr(text.find('\n') + 1);
+	}
+
+	// skipped entries, which would make the dataset invalid if they were read
+	std::vector<test_column> other = { { "other", parquet::Type::DOUBLE, {}, { 1.0 }, {} } };
+	write_test_file(test_dataset_file(dir, "year=2023/_temporary/part-0.parquet"), other, 8);
+	write_test_file(test_dataset_file(dir, "year=2024/.hidden.parquet"), other, 8);
+	write_test_file(test_dataset_file(dir, "_metadata.parquet"), other, 8);
+	FILE* success = fopen(test_dataset_file(dir, "_SUCCESS").c_str(), "w");
+	if (success != nullptr)
+		fclose(success);
+
+	std::string uri = driver_uri(dir) + "/";
+	int failed = check_driver_content("dataset read", uri, exp);
+	if (!driver_fileExists(uri.c_str())) {
+		std::cout << "dataset read test error: dataset directory not found as file." << std::endl;
+		failed++;
+	}
+
+	// positions across the member boundaries, from the end
+	void* stream = driver_fopen(uri.c_str(), 'r');
+	if (stream == nullptr) {
+		throw std::runtime_error("driver_fopen error during dataset read test.");
+	}
+	char buffer[100];
+	for (size_t back = 1; back <= exp.size(); back += 53) {
+		size_t offset = exp.size() - back;
+		size_t len = std::min(sizeof(buffer), exp.size() - offset);
+		long long code = driver_fseek(stream, (long long)offset, SEEK_SET) == 0 ? driver_fread(buffer, 1, sizeof(buffer), stream) : -1;
+		if (code != (long long)len || exp.compare(offset, len, buffer, len) != 0) {
+			std::cout << "dataset read test error: invalid read at offset " << offset << std::endl;
+			failed++;
+		}
+	}
+	driver_fclose(stream);
+	return failed;
+}
+
+// directories that cannot be read as a dataset: driver_fopen fails, and driver_fileExists agrees with it
+int test_dataset_errors() {
+	std::vector<test_column> columns = sample_columns(10);
+	std::vector<test_column> other_types = sample_columns(10);
+	other_types[0].type = parquet::Type::DOUBLE;
+	other_types[0].numbers.assign(10, 1.0);
+
+	std::vector<std::string> dirs;
+
+	// schema mismatch
+	dirs.push_back(test_data_dir("dataset_schema"));
+	write_test_file(test_dataset_file(dirs.back(), "part-0.parquet"), columns, 8);
+	write_test_file(test_dataset_file(dirs.back(), "part-1.parquet"), other_types, 8);
+
+	// column missing from a member
+	dirs.push_back(test_data_dir("dataset_columns"));
+	write_test_file(test_dataset_file(dirs.back(), "part-0.parquet"), columns, 8);
+	write_test_file(test_dataset_file(dirs.back(), "part-1.parquet"), { columns[0], columns[1] }, 8);
+
+	// partition keys differing between the members
+	dirs.push_back(test_data_dir("dataset_keys"));
+	write_test_file(test_dataset_file(dirs.back(), "a=1/part-0.parquet"), columns, 8);
+	write_test_file(test_dataset_file(dirs.back(), "b=1/part-0.parquet"), columns, 8);
+
+	// partition key that is also a column
+	dirs.push_back(test_data_dir("dataset_key_column"));
+	write_test_file(test_dataset_file(dirs.back(), "k=1/part-0.parquet"), columns, 8);
+
+	// no parquet file
+	dirs.push_back(test_data_dir("dataset_none"));
+	FILE* text = fopen(test_dataset_file(dirs.back(), "part-0.txt").c_str(), "w");
+	if (text != nullptr)
+		fclose(text);
+
+	int failed = 0;
+	for (const std::string& dir : dirs) {
+		std::string uri = driver_uri(dir) + "/";
+		void* stream = driver_fopen(uri.c_str(), 'r');
+		if (stream != nullptr) {
+			std::cout << "dataset errors test error: invalid dataset " << dir << " opened" << std::endl;
+			driver_fclose(stream);
+			failed++;
+		}
+		if (driver_getFileSize(uri.c_str()) != -1) {
+			std::cout << "dataset errors test error: size of invalid dataset " << dir << " doesn't return -1" << std::endl;
+			failed++;
+		}
+		if (driver_fileExists(uri.c_str())) {
+			std::cout << "dataset errors test error: invalid dataset " << dir << " found as file" << std::endl;
+			failed++;
+		}
+		if (!driver_dirExists(uri.c_str())) {
+			std::cout << "dataset errors test error: directory " << dir << " not found" << std::endl;
+			failed++;
+		}
+	}
+	return failed;
+}
+
 int test_driver_fileExists() {
 	int failed = 0;
 
@@ -481,10 +1108,12 @@ int test_driver_fileExists() {
 		failed++;
 	}
 
+	// a directory is a file only if driver_fopen can read it as a dataset: the tables of AccidentsMedium
+	// have different schemas (see test_dataset_errors)
 	path = "parquet://C/Users/Public/khiops_data/samples/AccidentsMedium/";
 	exist = driver_fileExists(path.c_str());
 	if (exist) {
-		std::cout << "driver_fileExists test error: directory found as file." << std::endl;
+		std::cout << "driver_fileExists test error: directory of incompatible files found as file." << std::endl;
 		failed++;
 	}
 
@@ -497,6 +1126,30 @@ int test_driver_fileExists() {
 	return failed;
 }
 
+// URIs of a local absolute path: parquet://C/path on windows and parquet:///path on linux (see driver_uri),
+// with any number of '/' after the scheme
+int test_driver_uri_paths() {
+	int failed = 0;
+	std::vector<test_column> columns = sample_columns(10);
+	std::string path = test_data_path("uri.parquet");
+	write_test_file(path, columns, 10);
+	std::string exp = expected_text({ &columns[0], &columns[1], &columns[2], &columns[3] }, all_rows(10));
+
+	std::string uri = driver_uri(path);
+	std::string extra_slash = uri;
+	extra_slash.insert(extra_slash.find("//") + 2, "/");
+	std::vector<std::string> uris = { uri, extra_slash };
+	for (const std::string& test_uri : uris) {
+		if (!driver_fileExists(test_uri.c_str())) {
+			std::cout << "driver uri test error: file not found for " << test_uri << std::endl;
+			failed++;
+			continue;
+		}
+		failed += check_driver_content("driver uri", test_uri, exp);
+	}
+	return failed;
+}
+
 int main() {
 	std::cout << "Driver tests:" << std::endl;
 
@@ -512,9 +1165,20 @@ int main() {
 	failed += test_driver_fseek_random();
 	failed += test_driver_fseek_all_file();
 	failed += test_driver_fseek_all_file_reverse();
+	failed += test_driver_pread();
+	failed += test_driver_split_points();
 
+	failed += test_value_format();
 	failed += test_file_size();
+	failed += test_constant_column_with_nan();
+	failed += test_float_file_size();
+	failed += test_projected_columns();
+	failed += test_filter_row_groups();
+	failed += test_filter_partial_pages();
+	failed += test_dataset_read();
+	failed += test_dataset_errors();
 	failed += test_driver_fileExists();
+	failed += test_driver_uri_paths();
 
 	if (failed == 0) {
 		std::cout << "PASSED: All tests passed" << std::endl;
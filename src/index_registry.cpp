@@ -0,0 +1,44 @@
+#include "index_registry.h"
+
+IndexRegistry& IndexRegistry::instance() {
+    static IndexRegistry registry;
+    return registry;
+}
+
+IndexRegistry::Index IndexRegistry::get(const std::string& key, uint64_t file_size, int64_t mtime) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) return nullptr;
+
+    // Fichier modifie depuis l'indexation : l'entree est abandonnee, les handles ouverts gardent leur index
+    if (it->second.file_size != file_size || it->second.mtime != mtime) {
+        entries.erase(it);
+        return nullptr;
+    }
+    return it->second.index;
+}
+
+IndexRegistry::Index IndexRegistry::put(const std::string& key, uint64_t file_size, int64_t mtime, Index index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it != entries.end() && it->second.file_size == file_size && it->second.mtime == mtime) {
+        return it->second.index;
+    }
+
+    entries[key] = Entry{ file_size, mtime, index };
+    if (entries.size() > kMaxEntries) {
+        releaseUnused();
+    }
+    return index;
+}
+
+void IndexRegistry::releaseUnused() {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.index.use_count() == 1) {
+            it = entries.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
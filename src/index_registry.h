@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+struct ParquetFileIndex;
+
+// Registre commun au processus des index logiques des fichiers ouverts.
+// Les handles d'un meme fichier partagent par compteur de references ses metadonnees et son
+// index, qui sont immuables une fois publies. Une entree est identifiee par le chemin et les
+// options d'indexation, et n'est rendue que si la taille et la date du fichier sont inchangees.
+class IndexRegistry {
+
+    public:
+        using Index = std::shared_ptr<const ParquetFileIndex>;
+
+        static IndexRegistry& instance();
+
+        // Returns the registered index of the file, nullptr if absent or stale
+        Index get(const std::string& key, uint64_t file_size, int64_t mtime);
+
+        // Enregistre index, sauf si un autre handle a deja publie celui du meme fichier.
+        // Returns the registered index.
+        Index put(const std::string& key, uint64_t file_size, int64_t mtime, Index index);
+
+    private:
+        // Nombre d'entrees au-dela duquel les index qui ne sont plus utilises par aucun handle sont liberes
+        static constexpr size_t kMaxEntries = 16;
+
+        struct Entry {
+            uint64_t file_size;
+            int64_t mtime;
+            Index index;
+        };
+
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+
+        void releaseUnused();
+};
@@ -8,12 +8,16 @@
 #endif
 
 #include "khiopsdriver_file_parquet.h"
-#include "parquet_file.h"
+#include "parquet_dataset.h"
+#include "call_trace.h"
 
 #if defined(__linux__) || defined(__APPLE__)
 #define __linux_or_apple__
 #endif
 
+#include <algorithm>
+#include <ctype.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
@@ -135,45 +139,148 @@ const char* getFilePath(const char* sFilePathName)
 		return sFilePathName;
 }
 
-int driver_fileExists(const char* filename)
+// Decode les sequences %XX d'un composant d'URI
+static std::string decodeUriComponent(const char* begin, const char* end)
 {
-	int bIsFile = false;
-
-	// Temporary solution because Khiops accept only one ':' 
-	// so impossible because this driver need the scheme (parquet://...)
-	// turning path from: C/path/to/file.parquet
-	// into: C:/path/to/file.parquet
+	std::string decoded;
+	decoded.reserve(end - begin);
+	for (const char* p = begin; p < end; p++)
+	{
+		if (*p == '%' && end - p > 2 && isxdigit((unsigned char)p[1]) && isxdigit((unsigned char)p[2]))
+		{
+			char hex[3] = { p[1], p[2], '\0' };
+			decoded += (char)strtol(hex, NULL, 16);
+			p += 2;
+		}
+		else
+			decoded += *p;
+	}
+	return decoded;
+}
 
+// Temporary solution because Khiops accept only one ':' 
+// so impossible because this driver need the scheme (parquet://...)
+// On windows, turning path from: C/path/to/file.parquet
+// into: C:/path/to/file.parquet
+// On linux, parquet:///path/to/file.parquet is the absolute path /path/to/file.parquet (see getFilePath)
+static std::string getValidPath(const char* filename)
+{
 	const char* file_path = getFilePath(filename);
+#ifdef _MSC_VER
+	if (file_path[0] != '\0')
+	{
+		std::string valid_path(file_path, 1);
+		valid_path += ':';
+		valid_path += file_path + 1;
+		return valid_path;
+	}
+#endif // _MSC_VER
+	return file_path;
+}
+
+// Options placees dans l'URI apres le chemin du fichier, de la forme 'cle=valeur' separees par '&'
+//  - columns=a,b,c : projection sur les colonnes listees, dans cet ordre
+//  - filter=expr : seules les lignes satisfaisant le filtre sont rendues (voir RowFilter)
+//  - mmap=0|1 : lecture du fichier par projection en memoire (KHIOPS_PARQUET_MMAP par defaut)
+// Le chemin est tronque avant le '?'. Renvoie 0 si une option est invalide
+int parseUriOptions(std::string& sFilePath, ParquetFileOptions& options)
+{
+	size_t query_start = sFilePath.find('?');
+	if (query_start == std::string::npos)
+		return 1;
+	std::string query_text = sFilePath.substr(query_start + 1);
+	sFilePath.resize(query_start);
+	char* query = &query_text[0];
+
+	while (*query != '\0')
+	{
+		char* option_end = strchr(query, '&');
+		if (option_end == NULL)
+			option_end = query + strlen(query);
+
+		char* value = (char*)memchr(query, '=', option_end - query);
+		if (value == NULL)
+			return 0;
 
-	char* valid_path = (char*)malloc((strlen(file_path) + 2) * sizeof(char));
-	if (valid_path == NULL) {
-		LogError("driver_fopen: Unable to malloc to add \':\' to path.");
-		return NULL;
+		std::string key = decodeUriComponent(query, value);
+		value++;
+		if (key == "columns")
+		{
+			// Les noms sont separes par des ',' ; une ',' dans un nom est encodee en %2C
+			options.columns.clear();
+			const char* name = value;
+			while (name <= option_end)
+			{
+				const char* name_end = (const char*)memchr(name, ',', option_end - name);
+				if (name_end == NULL)
+					name_end = option_end;
+				if (name_end == name)
+					return 0;
+				options.columns.push_back(decodeUriComponent(name, name_end));
+				name = name_end + 1;
+			}
+		}
+		else if (key == "filter")
+			options.filter = decodeUriComponent(value, option_end);
+		else if (key == "mmap")
+		{
+			std::string flag = decodeUriComponent(value, option_end);
+			if (flag != "0" && flag != "1")
+				return 0;
+			options.memory_map = flag == "1";
+		}
+		else
+			return 0;
+
+		query = *option_end == '&' ? option_end + 1 : option_end;
 	}
+	return 1;
+}
+
+static int fileExists(const char* filename)
+{
+	int bIsFile = false;
 
-	valid_path[0] = file_path[0];
-	valid_path[1] = ':';
-	for (size_t i = 1; i <= strlen(file_path); i++)
-		valid_path[i + 1] = file_path[i];
+	std::string valid_path = getValidPath(filename);
 
-	valid_path[strlen(file_path) + 1] = '\0';
-	// end of temporary solution
+	ParquetFileOptions options = ParquetFileOptions::FromEnvironment();
+	if (!parseUriOptions(valid_path, options))
+		return false;
 
+	int bIsDirectory = false;
 #ifdef _WIN32
 	struct __stat64 fileStat;
-	if (_stat64(valid_path, &fileStat) == 0)
+	if (_stat64(valid_path.c_str(), &fileStat) == 0)
+	{
 		bIsFile = ((fileStat.st_mode & S_IFMT) == S_IFREG);
+		bIsDirectory = ((fileStat.st_mode & S_IFMT) == S_IFDIR);
+	}
 #else
 	struct stat s;
-	if (stat(valid_path, &s) == 0)
+	if (stat(valid_path.c_str(), &s) == 0)
+	{
 		bIsFile = ((s.st_mode & S_IFMT) == S_IFREG);
+		bIsDirectory = ((s.st_mode & S_IFMT) == S_IFDIR);
+	}
 #endif // _WIN32
 
+	// Un repertoire de fichiers parquet est lu comme un seul fichier (voir ParquetDataset) si driver_fopen
+	// peut l'ouvrir : seuls les footers des fichiers sont lus pour verifier leurs schemas
+	if (bIsDirectory)
+	{
+		try {
+			CheckDatasetFiles(valid_path, options);
+			bIsFile = true;
+		}
+		catch (const std::exception&) {
+			bIsFile = false;
+		}
+	}
+
 	return bIsFile;
 }
 
-int driver_dirExists(const char* filename)
+static int dirExists(const char* filename)
 {
 	int bIsDirectory = false;
 
@@ -202,35 +309,23 @@ int driver_dirExists(const char* filename)
 	return bIsDirectory;
 }
 
-long long int driver_getFileSize(const char* filename)
+static long long int getFileSize(const char* filename)
 {
 	if (filename == nullptr) {
 		return -1;
 	}
 
-	// Temporary solution because Khiops accept only one ':' 
-	// so impossible because this driver need the scheme (parquet://...)
-	// turning path from: C/path/to/file.parquet
-	// into: C:/path/to/file.parquet
+	std::string valid_path = getValidPath(filename);
 
-	const char* file_path = getFilePath(filename);
-
-	char* valid_path = (char*)malloc((strlen(file_path) + 2) * sizeof(char));
-	if (valid_path == NULL) {
-		LogError("driver_getFileSize: Unable to malloc to add \':\' to path.");
+	ParquetFileOptions options = ParquetFileOptions::FromEnvironment();
+	if (!parseUriOptions(valid_path, options)) {
+		LogError("driver_getFileSize: Invalid URI options.");
 		return -1;
 	}
 
-	valid_path[0] = file_path[0];
-	valid_path[1] = ':';
-	for (size_t i = 1; i <= strlen(file_path); i++)
-		valid_path[i + 1] = file_path[i];
-
-	valid_path[strlen(file_path) + 1] = '\0';
-	// end of temporary solution
 	try {
-		ParquetFile parquetFile = ParquetFile(valid_path);
-		return parquetFile.logical_size;
+		ParquetDataset dataset(valid_path, options);
+		return dataset.logical_size;
 	}
 	catch (const std::exception& e) {
 		LogError("driver_getFileSize: Unable to open parquet file to get its size.");
@@ -238,7 +333,7 @@ long long int driver_getFileSize(const char* filename)
 	}
 }
 
-void* driver_fopen(const char* filename, char mode)
+static void* openFile(const char* filename, char mode)
 {
 	void* handle;
 
@@ -247,29 +342,16 @@ void* driver_fopen(const char* filename, char mode)
 		return nullptr;
 	}
 
-	// Temporary solution because Khiops accept only one ':' 
-	// so impossible because this driver need the scheme (parquet://...)
-	// turning path from: C/path/to/file.parquet
-	// into: C:/path/to/file.parquet
-
-	const char* file_path = getFilePath(filename);
+	std::string valid_path = getValidPath(filename);
 
-	char* valid_path = (char*)malloc((strlen(file_path) + 2) * sizeof(char));
-	if (valid_path == NULL) {
-		LogError("driver_fopen: Unable to malloc to add \':\' to path.");
-		return NULL;
+	ParquetFileOptions options = ParquetFileOptions::FromEnvironment();
+	if (!parseUriOptions(valid_path, options)) {
+		LogError("driver_fopen: Invalid URI options.");
+		return nullptr;
 	}
 
-	valid_path[0] = file_path[0];
-	valid_path[1] = ':';
-	for (size_t i = 1; i <= strlen(file_path); i++)
-		valid_path[i + 1] = file_path[i];
-
-	valid_path[strlen(file_path) + 1] = '\0';
-	// end of temporary solution
-
 	try {
-		handle = new ParquetFile(valid_path);
+		handle = new ParquetDataset(valid_path, options);
 	}
 	catch (...) {
 		LogError("driver_fopen: Unable to open parquet file.");
@@ -279,7 +361,7 @@ void* driver_fopen(const char* filename, char mode)
 	return handle;
 }
 
-int driver_fclose(void* stream)
+static int closeFile(void* stream)
 {
 	int code = EOF;
 	if (stream == nullptr) {
@@ -287,106 +369,277 @@ int driver_fclose(void* stream)
 		return code;
 	}
 
-	ParquetFile* parquetFile = static_cast<ParquetFile*>(stream);
-	if (parquetFile != NULL) {
+	ParquetDataset* dataset = static_cast<ParquetDataset*>(stream);
+	if (dataset != NULL) {
 		code = 0;
-		delete (ParquetFile*)stream;
+		delete dataset;
 	}
 
 	return code;
 }
 
-long long int driver_fread(void* ptr, size_t size, size_t count, void* stream)
+// Lit au plus totalBytesToRead octets du fichier a partir de sa position courante
+// Renvoie le nombre d'octets lus, -1 en cas d'erreur
+static long long int readParquetFile(ParquetFile* parquetFile, uint8_t* out, size_t totalBytesToRead)
 {
-	if (!ptr || !stream) {
-		LogError("driver_fread: NULL pointer argument.");
-		return -1;
-	}
-
-	ParquetFile* parquetFile = static_cast<ParquetFile*>(stream);
-	uint8_t* out = static_cast<uint8_t*>(ptr);  // important !
-	size_t totalBytesToRead = size * count;
 	size_t readcount = 0;
 
-	size_t rg = 0, col = 0, page = 0, val = 0;
+	// Les valeurs sont rendues directement dans le buffer de sortie ; seule une valeur
+	// a cheval sur la fin du buffer (ou deja entamee) passe par la zone tampon du fichier
+	std::vector<uint8_t>& scratch = parquetFile->scratch;
+
+	size_t rg = 0, col = 0;
+	int64_t row = 0;
+	uint64_t value_logical_start = 0;
 	size_t header = -1;
-	if (!parquetFile->findValueAtLogicalPosition(rg, col, page, val, header)) { 
+	if (!parquetFile->findValueAtLogicalPosition(rg, row, col, value_logical_start, header)) { 
 		return 0; 
 	}
 	else if (header != -1) {
-		while (readcount < totalBytesToRead && header < parquetFile->headers.size()) {
-			auto value_logical_start = parquetFile->headers[header].header_logical_start;
-			size_t offset_in_value = parquetFile->pos - value_logical_start;
-
-			std::string value;
-			if(!parquetFile->readHeader(header, value)) return -1;
-
-			size_t valueSize = value.size();
-
-			size_t nb_to_copy = min(valueSize - offset_in_value, totalBytesToRead - readcount);
-
-			std::memcpy(out + readcount, value.data() + offset_in_value, nb_to_copy);
+		while (readcount < totalBytesToRead && header < parquetFile->index->headers.size()) {
+			const HeaderIndex& header_idx = parquetFile->index->headers[header];
+			size_t offset_in_value = parquetFile->pos - header_idx.header_logical_start;
+			size_t valueSize = header_idx.header_logical_end - header_idx.header_logical_start + 1;
+
+			size_t nb_to_copy;
+			if (offset_in_value == 0 && valueSize <= totalBytesToRead - readcount) {
+				parquetFile->renderHeader(header, out + readcount);
+				nb_to_copy = valueSize;
+			}
+			else {
+				scratch.resize(valueSize);
+				parquetFile->renderHeader(header, scratch.data());
+				nb_to_copy = std::min(valueSize - offset_in_value, totalBytesToRead - readcount);
+				std::memcpy(out + readcount, scratch.data() + offset_in_value, nb_to_copy);
+			}
 			readcount += nb_to_copy;
 
 			parquetFile->pos += nb_to_copy;
 
-			if (parquetFile->pos > parquetFile->headers[header].header_logical_end) {
+			if (parquetFile->pos > header_idx.header_logical_end) {
 				header++;
 			}
 		}
+
+		// les valeurs commencent juste apres les en-tetes
+		value_logical_start = parquetFile->pos;
 	}
 
-	while (readcount < totalBytesToRead)
+	const RowBlockIndex* block = nullptr;
+	while (readcount < totalBytesToRead && rg < parquetFile->index->row_groups.size())
 	{
-		// reading value at offset
-		std::vector<uint8_t> valueBytes;
+		const RowGroupIndex& rg_idx = parquetFile->index->row_groups[rg];
+		if (row >= rg_idx.num_rows) {
+			// row group vide
+			row = 0;
+			rg++;
+			continue;
+		}
 
-		auto value_logical_start = parquetFile->row_groups[rg].columns[col].pages[page].values[val].value_logical_start;
-		size_t offset_in_value = parquetFile->pos - value_logical_start;
+		// Row group deja rendu dans le cache : simple copie
+		if (parquetFile->useRowGroupCache()) {
+			RowGroupCache::Text text = parquetFile->getRowGroupText(rg);
+			if (!text) {
+				LogError("driver_fread: Unable to render row group.");
+				return -1;
+			}
 
-		parquetFile->readValue(rg, col, page, val, valueBytes);
-		size_t valueSize = valueBytes.size();
+			size_t offset_in_rg = parquetFile->pos - rg_idx.rowgroup_logical_start;
+			size_t nb_to_copy = std::min(text->size() - offset_in_rg, totalBytesToRead - readcount);
 
-		size_t nb_to_copy = min(valueSize-offset_in_value, totalBytesToRead - readcount);
+			std::memcpy(out + readcount, text->data() + offset_in_rg, nb_to_copy);
+			readcount += nb_to_copy;
+			parquetFile->pos += nb_to_copy;
+
+			if (parquetFile->pos > rg_idx.rowgroup_logical_end) {
+				row = 0;
+				col = 0;
+				rg++;
+				value_logical_start = parquetFile->pos;
+			}
+			continue;
+		}
+
+		if (block == nullptr || !block->contains((int)rg, row)) {
+			block = &parquetFile->getRowBlock(rg, row);
+		}
+
+		// reading value at offset
+		size_t offset_in_value = parquetFile->pos - value_logical_start;
+		uint64_t valueSize = block->cellLength(row, col);
 
-		std::memcpy(out + readcount, valueBytes.data()+offset_in_value, nb_to_copy);
+		size_t nb_to_copy;
+		if (offset_in_value == 0 && valueSize <= totalBytesToRead - readcount) {
+			if (!parquetFile->renderValue(rg, (uint32_t)col, row, valueSize, out + readcount)) {
+				LogError("driver_fread: Unable to read value.");
+				return -1;
+			}
+			nb_to_copy = valueSize;
+		}
+		else {
+			scratch.resize(valueSize);
+			if (!parquetFile->renderValue(rg, (uint32_t)col, row, valueSize, scratch.data())) {
+				LogError("driver_fread: Unable to read value.");
+				return -1;
+			}
+			nb_to_copy = std::min(valueSize - offset_in_value, totalBytesToRead - readcount);
+			std::memcpy(out + readcount, scratch.data() + offset_in_value, nb_to_copy);
+		}
 		readcount += nb_to_copy;
 
 		parquetFile->pos += nb_to_copy;
 
-		const RowGroupIndex& rg_idx = parquetFile->row_groups[rg];
-		const ColumnIndex& col_idx = rg_idx.columns[col];
-		const PageIndex& page_idx = col_idx.pages[page];
+		value_logical_start += valueSize;
 
 		col++;
 
-		if (col >= rg_idx.columns.size()) {
+		if (col >= rg_idx.num_columns) {
 			col = 0;
-			val++;
-		}
-
-		if (val >= page_idx.values.size()) {
-			val = 0;
-			page++;
+			row++;
 		}
 
-		if (page >= col_idx.pages.size()) {
-			page = 0;
+		if (row >= rg_idx.num_rows) {
+			row = 0;
 			rg++;
 		}
+	}
 
+	return readcount;
+}
 
+// Lit au plus totalBytesToRead octets du jeu de donnees a partir de la position pos, avec le curseur
+// Les fichiers du jeu de donnees sont lus l'un a la suite de l'autre
+// Renvoie le nombre d'octets lus, -1 en cas d'erreur
+static long long int readDataset(ParquetDataset* dataset, DatasetCursor& cursor, uint64_t pos, uint8_t* out, size_t totalBytesToRead)
+{
+	size_t readcount = 0;
 
-		// Fin fichier
-		if (rg >= (int)parquetFile->row_groups.size()) {
-			break;
+	while (readcount < totalBytesToRead && pos < dataset->logical_size)
+	{
+		ParquetFile* parquetFile;
+		try {
+			parquetFile = &cursor.fileAt(pos);
 		}
+		catch (const std::exception&) {
+			LogError("driver_fread: Unable to open parquet file of the dataset.");
+			return -1;
+		}
+
+		long long int nb_read;
+		try {
+			nb_read = readParquetFile(parquetFile, out + readcount, totalBytesToRead - readcount);
+		}
+		catch (const std::exception&) {
+			LogError("driver_fread: Unable to read the index of the file.");
+			return -1;
+		}
+		if (nb_read < 0)
+			return -1;
+		if (nb_read == 0)
+			break;
+
+		readcount += nb_read;
+		pos += nb_read;
 	}
 
 	return readcount;
 }
 
-int driver_fseek(void* stream, long long int offset, int whence)
+static long long int readFile(void* ptr, size_t size, size_t count, void* stream)
+{
+	if (!ptr || !stream) {
+		LogError("driver_fread: NULL pointer argument.");
+		return -1;
+	}
+
+	ParquetDataset* dataset = static_cast<ParquetDataset*>(stream);
+	uint8_t* out = static_cast<uint8_t*>(ptr);  // important !
+
+	long long int readcount = readDataset(dataset, dataset->cursor(), dataset->pos, out, size * count);
+	if (readcount > 0)
+		dataset->pos += readcount;
+	return readcount;
+}
+
+static long long int readFileAt(void* stream, long long int offset, void* ptr, size_t len)
+{
+	if (!ptr || !stream) {
+		LogError("driver_pread: NULL pointer argument.");
+		return -1;
+	}
+
+	ParquetDataset* dataset = static_cast<ParquetDataset*>(stream);
+	if (offset < 0 || (unsigned long long)offset > dataset->logical_size) {
+		LogError("driver_pread: Invalid offset.");
+		return -1;
+	}
+
+	// Etat de decodage emprunte pour la duree de la lecture : la position courante n'est pas modifiee
+	std::unique_ptr<DatasetCursor> cursor = dataset->acquireCursor();
+	long long int readcount = readDataset(dataset, *cursor, (uint64_t)offset, static_cast<uint8_t*>(ptr), len);
+	dataset->releaseCursor(std::move(cursor));
+	return readcount;
+}
+
+static int getSplitPoints(void* stream, const long long int* targets, long long int* split_points, size_t count, long long int tolerance)
+{
+	if (!stream || (count > 0 && (!targets || !split_points)) || tolerance < 0) {
+		LogError("driver_getSplitPoints: NULL pointer or invalid argument.");
+		return -1;
+	}
+
+	ParquetDataset* dataset = static_cast<ParquetDataset*>(stream);
+	std::unique_ptr<DatasetCursor> cursor = dataset->acquireCursor();
+	int code = 0;
+	try {
+		for (size_t i = 0; i < count; i++)
+		{
+			if (targets[i] < 0) {
+				LogError("driver_getSplitPoints: Negative target offset.");
+				code = -1;
+				break;
+			}
+			split_points[i] = (long long int)cursor->rowAlignedOffset((uint64_t)targets[i], (uint64_t)tolerance);
+		}
+	}
+	catch (const std::exception&) {
+		LogError("driver_getSplitPoints: Unable to read the index of the file.");
+		code = -1;
+	}
+	dataset->releaseCursor(std::move(cursor));
+	return code;
+}
+
+static long long int getLineOffset(void* stream, long long int line)
+{
+	if (!stream) {
+		LogError("driver_getLineOffset: NULL ParquetFile pointer.");
+		return -1;
+	}
+
+	// La ligne 0 est l'en-tete, la ligne n la n-ieme ligne de donnees
+	ParquetDataset* dataset = static_cast<ParquetDataset*>(stream);
+	if (line < 0 || line > dataset->num_rows + 1) {
+		LogError("driver_getLineOffset: Invalid line number.");
+		return -1;
+	}
+	if (line == 0)
+		return 0;
+
+	std::unique_ptr<DatasetCursor> cursor = dataset->acquireCursor();
+	long long int offset;
+	try {
+		offset = (long long int)cursor->rowOffset(line - 1);
+	}
+	catch (const std::exception&) {
+		LogError("driver_getLineOffset: Unable to read the index of the file.");
+		offset = -1;
+	}
+	dataset->releaseCursor(std::move(cursor));
+	return offset;
+}
+
+static int seekFile(void* stream, long long int offset, int whence)
 {
 	int ok = 0;
 	if (stream == nullptr) {
@@ -394,25 +647,26 @@ int driver_fseek(void* stream, long long int offset, int whence)
 		return -1;
 	}
 
-	ParquetFile* parquetFile = static_cast<ParquetFile*>(stream);
-	if (parquetFile == NULL) return -1; // possiblement inutile
-		
+	ParquetDataset* dataset = static_cast<ParquetDataset*>(stream);
+	if (dataset == NULL) return -1; // possiblement inutile
+
+	const long long int logical_size = (long long int)dataset->logical_size;
 
 	if (whence == std::ios::beg) {
-		if (offset >= 0 && offset <= (long long int)parquetFile->logical_size) {
-			parquetFile->pos = offset;
+		if (offset >= 0 && offset <= logical_size) {
+			dataset->pos = offset;
 			return 0;
 		}
 	}
 	else if (whence == std::ios::cur) {
-		if (parquetFile->pos + offset >= 0 && parquetFile->pos + offset <= (long long int)parquetFile->logical_size) {
-			parquetFile->pos += offset;
+		if (dataset->pos + offset >= 0 && dataset->pos + offset <= logical_size) {
+			dataset->pos += offset;
 			return 0;
 		}
 	}
 	else if (whence == std::ios::end) {
-		if (parquetFile->logical_size + offset >= 0 && parquetFile->logical_size + offset <= (long long int)parquetFile->logical_size) {
-			parquetFile->pos = parquetFile->logical_size + offset;
+		if (logical_size + offset >= 0 && logical_size + offset <= logical_size) {
+			dataset->pos = logical_size + offset;
 			return 0;
 		}
 	}
@@ -425,6 +679,108 @@ int driver_fseek(void* stream, long long int offset, int whence)
 	return -1;
 }
 
+// Points d'entree de l'API : chaque appel est ajoute a la trace si KHIOPS_PARQUET_TRACE est defini (voir call_trace.h)
+
+int driver_fileExists(const char* filename)
+{
+	CallTrace* trace = CallTrace::instance();
+	if (!trace)
+		return fileExists(filename);
+	TraceRecord record = trace->begin(TraceCall::FileExists, nullptr, 0, 0, filename);
+	return trace->end(record, fileExists(filename));
+}
+
+int driver_dirExists(const char* filename)
+{
+	CallTrace* trace = CallTrace::instance();
+	if (!trace)
+		return dirExists(filename);
+	TraceRecord record = trace->begin(TraceCall::DirExists, nullptr, 0, 0, filename);
+	return trace->end(record, dirExists(filename));
+}
+
+long long int driver_getFileSize(const char* filename)
+{
+	CallTrace* trace = CallTrace::instance();
+	if (!trace)
+		return getFileSize(filename);
+	TraceRecord record = trace->begin(TraceCall::GetFileSize, nullptr, 0, 0, filename);
+	return trace->end(record, getFileSize(filename));
+}
+
+void* driver_fopen(const char* filename, char mode)
+{
+	CallTrace* trace = CallTrace::instance();
+	if (!trace)
+		return openFile(filename, mode);
+	TraceRecord record = trace->begin(TraceCall::Open, nullptr, mode, 0, filename);
+	void* handle = openFile(filename, mode);
+	if (handle)
+		trace->openStream(record, handle);
+	trace->end(record, handle ? 1 : 0);
+	return handle;
+}
+
+int driver_fclose(void* stream)
+{
+	CallTrace* trace = CallTrace::instance();
+	if (!trace)
+		return closeFile(stream);
+	TraceRecord record = trace->begin(TraceCall::Close, stream);
+	trace->closeStream(stream);
+	return trace->end(record, closeFile(stream));
+}
+
+long long int driver_fread(void* ptr, size_t size, size_t count, void* stream)
+{
+	CallTrace* trace = CallTrace::instance();
+	if (!trace)
+		return readFile(ptr, size, count, stream);
+	TraceRecord record = trace->begin(TraceCall::Read, stream, (long long int)size, (long long int)count);
+	return trace->end(record, readFile(ptr, size, count, stream));
+}
+
+long long int driver_pread(void* stream, long long int offset, void* ptr, size_t len)
+{
+	CallTrace* trace = CallTrace::instance();
+	if (!trace)
+		return readFileAt(stream, offset, ptr, len);
+	TraceRecord record = trace->begin(TraceCall::PositionalRead, stream, offset, (long long int)len);
+	return trace->end(record, readFileAt(stream, offset, ptr, len));
+}
+
+long long int driver_getLineOffset(void* stream, long long int line)
+{
+	CallTrace* trace = CallTrace::instance();
+	if (!trace)
+		return getLineOffset(stream, line);
+	TraceRecord record = trace->begin(TraceCall::LineOffset, stream, line);
+	return trace->end(record, getLineOffset(stream, line));
+}
+
+int driver_getSplitPoints(void* stream, const long long int* targets, long long int* split_points, size_t count, long long int tolerance)
+{
+	CallTrace* trace = CallTrace::instance();
+	if (!trace)
+		return getSplitPoints(stream, targets, split_points, count, tolerance);
+	TraceRecord record = trace->begin(TraceCall::SplitPoints, stream, (long long int)count, tolerance);
+	if (targets)
+		record.targets.assign(targets, targets + count);
+	int code = getSplitPoints(stream, targets, split_points, count, tolerance);
+	if (code == 0)
+		record.split_points.assign(split_points, split_points + count);
+	return trace->end(record, code);
+}
+
+int driver_fseek(void* stream, long long int offset, int whence)
+{
+	CallTrace* trace = CallTrace::instance();
+	if (!trace)
+		return seekFile(stream, offset, whence);
+	TraceRecord record = trace->begin(TraceCall::Seek, stream, offset, whence);
+	return trace->end(record, seekFile(stream, offset, whence));
+}
+
 const char* driver_getlasterror()
 {
 	return g_lastError;
@@ -23,6 +23,8 @@ extern "C"
 	// Obviously, driver_fopen corresponds to fopen in the C ANSI and so on for driver_fclose, driver_fread,
 	// driver_fread, driver_fwrite.... These methods are not well documented here, please refer to the C library.
 	// However, "driver_" methods sometimes differ from the ANSI C methods by their return values.
+	// Setting the KHIOPS_PARQUET_TRACE environment variable to a file name records the file calls, with their arguments,
+	// result and duration, in a binary trace (see call_trace.h) that parquet_reader_replay runs again.
 
 	// Name of the driver, used for messages or errors only
 	VISIBLE const char* driver_getDriverName();
@@ -56,7 +58,8 @@ extern "C"
 	///////////////////////////////////////////////////////////////////////////////////
 	// The following read-only functions are mandatory and they need to be implemented
 
-	// Returns 1 if the file exists, 0 otherwise
+	// Returns 1 if the file exists, 0 otherwise. A directory of parquet files is a file if it can be
+	// opened as a dataset by driver_fopen (compatible schemas, see ParquetDataset).
 	VISIBLE int driver_fileExists(const char* filename);
 
 	// Returns 1 if the directory exists, 0 otherwise
@@ -84,6 +87,25 @@ extern "C"
 	// Note that the return type is long long int rather than size_t in order to manage the -1 value
 	VISIBLE long long int driver_fread(void* ptr, size_t size, size_t count, void* stream);
 
+	// Reads up to len bytes starting at offset, as pread in POSIX: the position of the stream is neither
+	// used nor modified. Several threads may call driver_pread on the same stream at the same time,
+	// and concurrently with driver_fread and driver_fseek called from one other thread.
+	// Returns the number of bytes read (less than len only at the end of the file), -1 on error
+	VISIBLE long long int driver_pread(void* stream, long long int offset, void* ptr, size_t len);
+
+	// Split points for parallel scans of the stream in byte ranges of whole lines.
+	// For each of the count target offsets, writes in split_points the start offset of a line near the target:
+	// the start of the nearest row group if it lies within tolerance bytes of the target (the columns are then
+	// read from their first page), otherwise the start of the first line beginning at or after the target.
+	// A target of 0 gives 0 (start of the header line); a target at or past the end gives the file size.
+	// Split points are non-decreasing for non-decreasing targets. Thread-safe as driver_pread.
+	// Returns 0 on success, -1 on error
+	VISIBLE int driver_getSplitPoints(void* stream, const long long int* targets, long long int* split_points, size_t count, long long int tolerance);
+
+	// Returns the start offset of a line of the stream (line 0 is the header line, line n the n-th data row),
+	// the file size for the line following the last one, -1 on error. Thread-safe as driver_pread.
+	VISIBLE long long int driver_getLineOffset(void* stream, long long int line);
+
 	// Returns 0 on success, -1 on error
 	// Supports files larger than 4 Gb
 	VISIBLE int driver_fseek(void* stream, long long int offset, int whence);
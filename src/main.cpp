@@ -58,8 +58,6 @@ int read_whole_file(const std::string path) {
         std::cerr << "Error: driver_fopen failed" << std::endl;
         return 1;
     }
-    auto pd = (ParquetFile*)driver;
-    //pd->dumpInfo();
 
     size_t buffer_size = 10000;
     void* buf = calloc(1, buffer_size + 1);
@@ -0,0 +1,334 @@
+#include "parquet_dataset.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Valeur Hive d'une partition nulle
+constexpr char kHiveNullPartition[] = "__HIVE_DEFAULT_PARTITION__";
+
+// Decode les sequences %XX d'un nom de repertoire de partition
+std::string DecodePartitionText(const std::string& text) {
+    std::string decoded;
+    decoded.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '%' && i + 2 < text.size() && std::isxdigit(static_cast<unsigned char>(text[i + 1])) &&
+            std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+            const char hex[3] = { text[i + 1], text[i + 2], '\0' };
+            decoded += static_cast<char>(std::strtol(hex, nullptr, 16));
+            i += 2;
+        }
+        else {
+            decoded += text[i];
+        }
+    }
+    return decoded;
+}
+
+// Cles de partition des repertoires key=value du chemin relatif d'un fichier
+std::vector<PartitionColumn> PartitionColumns(const std::filesystem::path& relative_dir) {
+    std::vector<PartitionColumn> partition_columns;
+    for (const std::filesystem::path& component : relative_dir) {
+        const std::string name = component.string();
+        const size_t eq = name.find('=');
+        if (eq == std::string::npos || eq == 0) continue;
+
+        PartitionColumn partition;
+        partition.name = DecodePartitionText(name.substr(0, eq));
+        partition.value = DecodePartitionText(name.substr(eq + 1));
+        if (partition.value == kHiveNullPartition) partition.value.clear();
+        partition_columns.push_back(std::move(partition));
+    }
+    return partition_columns;
+}
+
+// Colonnes projetees d'un fichier du jeu de donnees, d'apres son footer
+struct FileColumns {
+    std::string path;
+    const parquet::SchemaDescriptor* schema;
+    std::vector<int> columns;
+};
+
+// Les colonnes projetees de deux fichiers doivent avoir les memes chemins, types et repetitions
+bool SameColumns(const FileColumns& first, const FileColumns& other) {
+    if (first.columns.size() != other.columns.size()) return false;
+
+    for (size_t col = 0; col < first.columns.size(); col++) {
+        const parquet::ColumnDescriptor* first_column = first.schema->Column(first.columns[col]);
+        const parquet::ColumnDescriptor* other_column = other.schema->Column(other.columns[col]);
+        if (first_column->path()->ToDotString() != other_column->path()->ToDotString() || !first_column->Equals(*other_column)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Throws if a partition key is also a column, or if the files don't have the same projected columns
+void CheckColumns(const std::vector<FileColumns>& files, const std::vector<PartitionColumn>& partition_columns) {
+    const FileColumns& first = files[0];
+    for (const PartitionColumn& partition : partition_columns) {
+        for (int col : first.columns) {
+            if (first.schema->Column(col)->path()->ToDotString() == partition.name) {
+                throw std::runtime_error("Partition key is also a column: " + partition.name);
+            }
+        }
+    }
+    for (const FileColumns& file : files) {
+        if (!SameColumns(first, file)) {
+            throw std::runtime_error("Incompatible schema: " + file.path);
+        }
+    }
+}
+
+// Execute task(i) pour i < count sur au plus num_threads threads (0 : un par thread materiel).
+// La premiere exception arrete la distribution des taches et est relancee.
+void ParallelFor(size_t count, unsigned num_threads, const std::function<void(size_t)>& task) {
+    if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+    num_threads = static_cast<unsigned>(std::min<size_t>(num_threads, count));
+
+    std::atomic<size_t> next{ 0 };
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next++) < count) {
+            try {
+                task(i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+                next = count;
+            }
+        }
+    };
+
+    if (num_threads <= 1) {
+        worker();
+    }
+    else {
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads);
+        for (unsigned t = 0; t < num_threads; t++) {
+            threads.emplace_back(worker);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    if (error) std::rethrow_exception(error);
+}
+
+} // namespace
+
+std::vector<DatasetFile> FindDatasetFiles(const std::string& dir) {
+    const std::filesystem::path root(dir);
+
+    std::vector<std::filesystem::path> paths;
+    for (auto it = std::filesystem::recursive_directory_iterator(root); it != std::filesystem::recursive_directory_iterator(); ++it) {
+        // Fichiers caches ou de travail (_SUCCESS, _temporary, ...)
+        const std::string name = it->path().filename().string();
+        if (name.empty() || name[0] == '.' || name[0] == '_') {
+            if (it->is_directory()) it.disable_recursion_pending();
+            continue;
+        }
+        if (it->is_regular_file() && it->path().extension() == ".parquet") {
+            paths.push_back(it->path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<DatasetFile> files;
+    files.reserve(paths.size());
+    for (const std::filesystem::path& path : paths) {
+        DatasetFile file;
+        file.path = path.string();
+        file.partition_columns = PartitionColumns(path.lexically_relative(root).parent_path());
+
+        if (!files.empty()) {
+            const std::vector<PartitionColumn>& first = files.front().partition_columns;
+            const bool same_keys = std::equal(first.begin(), first.end(), file.partition_columns.begin(), file.partition_columns.end(),
+                [](const PartitionColumn& a, const PartitionColumn& b) { return a.name == b.name; });
+            if (!same_keys) throw std::runtime_error("Inconsistent partition keys: " + file.path);
+        }
+        files.push_back(std::move(file));
+    }
+    return files;
+}
+
+void CheckDatasetFiles(const std::string& dir, const ParquetFileOptions& options) {
+    const std::vector<DatasetFile> files = FindDatasetFiles(dir);
+    if (files.empty()) throw std::runtime_error("No parquet file in directory: " + dir);
+
+    // Footers lus en parallele ; les metadonnees gardent les schemas
+    std::vector<std::shared_ptr<parquet::FileMetaData>> metadata(files.size());
+    std::vector<FileColumns> columns(files.size());
+    ParallelFor(files.size(), options.index_threads, [&](size_t f) {
+        metadata[f] = parquet::ParquetFileReader::OpenFile(files[f].path, false)->metadata();
+        const parquet::SchemaDescriptor* schema = metadata[f]->schema();
+        columns[f] = FileColumns{ files[f].path, schema, ResolveColumns(*schema, options.columns) };
+        RowFilter::Parse(options.filter, *schema);
+    });
+    CheckColumns(columns, files[0].partition_columns);
+}
+
+ParquetDataset::ParquetDataset(const std::string& path, const ParquetFileOptions& options) {
+    std::vector<DatasetFile> files;
+    std::error_code ec;
+    if (std::filesystem::is_directory(path, ec)) {
+        files = FindDatasetFiles(path);
+        if (files.empty()) throw std::runtime_error("No parquet file in directory: " + path);
+    }
+    else {
+        files.push_back(DatasetFile{ path, {} });
+    }
+
+    unsigned num_threads = options.index_threads;
+    if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Seul le premier fichier rend l'en-tete ; les threads d'indexation sont repartis entre les fichiers
+    members.resize(files.size());
+    for (size_t m = 0; m < files.size(); m++) {
+        Member& member = members[m];
+        member.path = files[m].path;
+        member.options = options;
+        member.options.header = m == 0;
+        member.options.partition_columns = files[m].partition_columns;
+        if (files.size() > 1) {
+            member.options.index_threads = std::max<unsigned>(1, num_threads / static_cast<unsigned>(files.size()));
+        }
+    }
+
+    // Footers lus et fichiers indexes en parallele ; seul le handle du premier fichier reste ouvert
+    ParallelFor(members.size(), num_threads, [&](size_t m) {
+        auto file = std::make_unique<ParquetFile>(members[m].path, members[m].options);
+        members[m].index = file->index;
+        if (m == 0) {
+            stream_cursor.current = std::move(file);
+            stream_cursor.current_member = 0;
+        }
+    });
+
+    // Schemas compatibles, puis somme prefixe des tailles logiques des fichiers
+    std::vector<FileColumns> columns;
+    columns.reserve(members.size());
+    for (const Member& member : members) {
+        columns.push_back(FileColumns{ member.path, member.index->metadata->schema(), member.index->columns });
+    }
+    CheckColumns(columns, members[0].options.partition_columns);
+
+    for (Member& member : members) {
+        member.logical_start = logical_size;
+        logical_size += member.index->logical_size;
+
+        member.first_row = num_rows;
+        for (const RowGroupIndex& rg_idx : member.index->row_groups) {
+            num_rows += rg_idx.num_rows;
+        }
+    }
+}
+
+std::unique_ptr<ParquetFile> ParquetDataset::openMember(size_t m) const {
+    // L'index du fichier est retrouve dans le registre : seul un lecteur est ouvert
+    const Member& member = members[m];
+    auto file = std::make_unique<ParquetFile>(member.path, member.options);
+    if (file->index->logical_size != member.index->logical_size) {
+        throw std::runtime_error("File changed since the dataset was opened: " + member.path);
+    }
+    return file;
+}
+
+std::unique_ptr<DatasetCursor> ParquetDataset::acquireCursor() {
+    {
+        std::lock_guard<std::mutex> lock(cursors_mutex);
+        if (!free_cursors.empty()) {
+            std::unique_ptr<DatasetCursor> cursor = std::move(free_cursors.back());
+            free_cursors.pop_back();
+            return cursor;
+        }
+    }
+    return std::make_unique<DatasetCursor>(*this);
+}
+
+void ParquetDataset::releaseCursor(std::unique_ptr<DatasetCursor> cursor) {
+    std::lock_guard<std::mutex> lock(cursors_mutex);
+    free_cursors.push_back(std::move(cursor));
+}
+
+size_t ParquetDataset::memberAt(uint64_t pos) const {
+    // Dernier fichier commencant au plus tard a pos
+    auto it = std::upper_bound(members.begin(), members.end(), pos,
+        [](uint64_t pos, const Member& member) { return pos < member.logical_start; });
+    return static_cast<size_t>(std::distance(members.begin(), it) - 1);
+}
+
+size_t ParquetDataset::memberOfRow(int64_t row) const {
+    auto it = std::upper_bound(members.begin(), members.end(), row,
+        [](int64_t row, const Member& member) { return row < member.first_row; });
+    return static_cast<size_t>(std::distance(members.begin(), it) - 1);
+}
+
+ParquetFile& DatasetCursor::file(size_t m) {
+    if (!current || current_member != m) {
+        current.reset();
+        if (next && next_member == m) {
+            current = std::move(next);
+        }
+        else {
+            next.reset();
+            current = dataset.openMember(m);
+        }
+        current_member = m;
+    }
+    return *current;
+}
+
+ParquetFile& DatasetCursor::fileAt(uint64_t pos) {
+    const std::vector<ParquetDataset::Member>& members = dataset.members;
+    const size_t m = dataset.memberAt(pos);
+    const ParquetDataset::Member& member = members[m];
+
+    file(m).pos = pos - member.logical_start;
+
+    // Dernier row group du fichier : le fichier suivant est ouvert pour lire d'avance ses premiers row groups.
+    // Un echec est ignore, il sera signale a la lecture du fichier.
+    const std::vector<RowGroupIndex>& row_groups = member.index->row_groups;
+    const bool last_row_group = row_groups.empty() || current->pos >= row_groups.back().rowgroup_logical_start;
+    if (!next && last_row_group && m + 1 < members.size() && member.options.prefetch_row_groups > 0 && !member.options.memory_map) {
+        try {
+            next = dataset.openMember(m + 1);
+            next_member = m + 1;
+            next->prefetchStart();
+        }
+        catch (const std::exception&) {
+            next.reset();
+        }
+    }
+    return *current;
+}
+
+uint64_t DatasetCursor::rowAlignedOffset(uint64_t target, uint64_t tolerance) {
+    if (target >= dataset.logical_size) return dataset.logical_size;
+
+    const size_t m = dataset.memberAt(target);
+    const ParquetDataset::Member& member = dataset.members[m];
+    return member.logical_start + file(m).rowAlignedOffset(target - member.logical_start, tolerance);
+}
+
+uint64_t DatasetCursor::rowOffset(int64_t row) {
+    if (row >= dataset.num_rows) return dataset.logical_size;
+
+    const size_t m = dataset.memberOfRow(row);
+    const ParquetDataset::Member& member = dataset.members[m];
+    return member.logical_start + file(m).rowOffset(row - member.first_row);
+}
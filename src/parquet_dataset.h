@@ -0,0 +1,118 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <mutex>
+
+#include "parquet_file.h"
+
+// Fichier parquet d'un jeu de donnees et ses cles de partition
+struct DatasetFile {
+    std::string path;
+    std::vector<PartitionColumn> partition_columns;
+};
+
+// Fichiers .parquet d'un repertoire et de ses sous-repertoires, tries par chemin. Les fichiers et
+// repertoires dont le nom commence par '.' ou '_' sont ignores. Les repertoires de la forme key=value
+// (partitionnement Hive, valeurs decodees des sequences %XX) donnent les cles de partition du fichier.
+// Throws if the files are not partitioned by the same keys, in the same order.
+std::vector<DatasetFile> FindDatasetFiles(const std::string& dir);
+
+// Verifie en ne lisant que les footers des fichiers qu'un repertoire peut etre ouvert comme jeu de
+// donnees avec ces options : colonnes projetees et filtre valides, memes colonnes projetees dans tous
+// les fichiers, cles de partition distinctes des colonnes. Les fichiers ne sont pas indexes.
+// Throws like the ParquetDataset constructor.
+void CheckDatasetFiles(const std::string& dir, const ParquetFileOptions& options);
+
+class ParquetDataset;
+
+// Etat de lecture d'un jeu de donnees : handle du fichier en cours de lecture, et du suivant des que
+// la lecture atteint le dernier row group du fichier (ses premiers column chunks sont alors lus d'avance).
+// Un curseur ne doit etre utilise que par un thread a la fois.
+class DatasetCursor {
+
+    public:
+        explicit DatasetCursor(const ParquetDataset& dataset) : dataset(dataset) {}
+
+        // Handle du fichier contenant la position pos du jeu de donnees, positionne sur elle (pos < logical_size).
+        // Throws if the file cannot be opened again or has changed since the dataset was opened.
+        ParquetFile& fileAt(uint64_t pos);
+
+        // Debut de ligne du jeu de donnees proche de target (voir ParquetFile::rowAlignedOffset) : le debut
+        // d'un fichier est aussi celui d'un row group. Throws like fileAt.
+        uint64_t rowAlignedOffset(uint64_t target, uint64_t tolerance);
+
+        // Offset du debut de la ligne row du jeu de donnees (0 <= row <= num_rows). Throws like fileAt.
+        uint64_t rowOffset(int64_t row);
+
+    private:
+        friend class ParquetDataset;
+
+        const ParquetDataset& dataset;
+
+        size_t current_member = 0;
+        std::unique_ptr<ParquetFile> current;
+
+        size_t next_member = 0;
+        std::unique_ptr<ParquetFile> next;
+
+        // Handle du fichier m, ouvert s'il n'est pas celui en cours de lecture
+        ParquetFile& file(size_t m);
+};
+
+// Jeu de donnees parquet lu comme un seul flux : un fichier, ou tous les fichiers d'un repertoire
+// (voir FindDatasetFiles) concatenes dans l'ordre de leurs chemins sous une seule ligne d'en-tete,
+// les cles de partition etant rendues comme des colonnes apres celles des fichiers.
+// Les fichiers sont indexes en parallele a l'ouverture ; leurs index restent partages par le
+// registre, seuls les fichiers en cours de lecture par un curseur ayant un handle ouvert.
+// La position courante a son propre curseur ; les lectures positionnelles empruntent chacune
+// un curseur libre, et peuvent etre faites en parallele.
+class ParquetDataset {
+
+    public:
+        uint64_t pos = 0;               // logical current position
+        uint64_t logical_size = 0;
+        int64_t num_rows = 0;           // lignes rendues, sans l'en-tete
+
+        // Throws if a file cannot be opened, if the directory holds no parquet file, or if the
+        // files do not have the same projected columns (path, type and repetition)
+        ParquetDataset(const std::string& path, const ParquetFileOptions& options = ParquetFileOptions());
+
+        size_t numFiles() const { return members.size(); }
+
+        // Curseur de la position courante
+        DatasetCursor& cursor() { return stream_cursor; }
+
+        // Curseur reserve au thread appelant jusqu'a sa restitution par releaseCursor (thread-safe)
+        std::unique_ptr<DatasetCursor> acquireCursor();
+        void releaseCursor(std::unique_ptr<DatasetCursor> cursor);
+
+    private:
+        struct Member {
+            std::string path;
+            ParquetFileOptions options;
+            std::shared_ptr<const ParquetFileIndex> index;  // garde l'index du fichier dans le registre
+            uint64_t logical_start;
+            int64_t first_row;                              // rang de sa premiere ligne dans le jeu de donnees
+        };
+
+        friend class DatasetCursor;
+
+        std::vector<Member> members;
+
+        DatasetCursor stream_cursor{ *this };
+
+        // Curseurs libres des lectures positionnelles, un par thread ayant lu en parallele
+        std::mutex cursors_mutex;
+        std::vector<std::unique_ptr<DatasetCursor>> free_cursors;
+
+        // Throws if the file has changed since the dataset was opened
+        std::unique_ptr<ParquetFile> openMember(size_t m) const;
+
+        // Fichier contenant la position pos (pos < logical_size), ou la ligne row (row < num_rows),
+        // les fichiers vides etant sautes
+        size_t memberAt(uint64_t pos) const;
+        size_t memberOfRow(int64_t row) const;
+};
@@ -1,11 +1,22 @@
 #pragma once
 
 #include "parquet_file.h"
+#include "value_format.h"
+#include "sidecar_index.h"
+#include "index_registry.h"
 
 #include <memory>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <vector>
 #include <cstdint>
 #include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <filesystem>
 
 #include <arrow/api.h>
 #include <arrow/io/api.h>
@@ -14,31 +25,177 @@
 #include <parquet/arrow/reader.h>
 #include <parquet/api/reader.h>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 using parquet::TypedColumnReader;
 using parquet::Type;
 
 char sep = '\t';
 
-void ParquetFile::BuildLogicalIndex() {
-    if (!reader || !metadata)
-        throw std::runtime_error("Parquet reader or metadata not initialized");
+namespace {
+
+// Taille rendue d'une colonne de partition, la meme pour toutes les lignes
+class ConstantLengths : public ColumnLengths {
+
+    public:
+        explicit ConstantLengths(uint64_t len) : len(len) {}
+
+        void read(const RowRange* ranges, size_t num_ranges, uint64_t* lens) override {
+            int64_t num_rows = 0;
+            for (size_t r = 0; r < num_ranges; r++) {
+                num_rows += ranges[r].num_rows;
+            }
+            std::fill(lens, lens + num_rows, len);
+        }
 
+    private:
+        uint64_t len;
+};
+
+// Ouvre le calcul des tailles rendues des colonnes d'un row group, sans leurs pages sautees, a partir
+// de la page de la ligne first_row si l'acces direct aux pages de chaque colonne est donne par seeks.
+// Les colonnes de partition suivent les colonnes parquet.
+std::vector<std::unique_ptr<ColumnLengths>> OpenColumnLengths(parquet::RowGroupReader& rg_reader,
+                                                              const std::vector<int>& columns,
+                                                              const std::vector<std::string>& partition_values,
+                                                              const std::vector<std::shared_ptr<const SkippedPages>>& pages,
+                                                              const std::vector<PageSeek>& seeks = {},
+                                                              int64_t first_row = 0) {
+    std::vector<std::unique_ptr<ColumnLengths>> col_lengths(columns.size() + partition_values.size());
+    for (size_t col = 0; col < columns.size(); col++) {
+        col_lengths[col] = ColumnLengths::Make(rg_reader, columns[col], pages.empty() ? nullptr : pages[col],
+                                               seeks.empty() ? PageSeek() : seeks[col], first_row);
+    }
+    for (size_t p = 0; p < partition_values.size(); p++) {
+        col_lengths[columns.size() + p] = std::make_unique<ConstantLengths>(partition_values[p].size() + 1);
+    }
+    return col_lengths;
+}
+
+using OffsetIndexes = std::vector<std::shared_ptr<parquet::OffsetIndex>>;
+
+// Index des offsets des pages des colonnes du row group, par indice de colonne parquet (nullptr si
+// absent). Sans index des pages lisible, aucun index n'est rendu et toutes les pages sont lues.
+OffsetIndexes ReadOffsetIndexes(parquet::ParquetFileReader& file_reader, int rg, const std::vector<int>& columns) {
+    OffsetIndexes offset_indexes;
+    try {
+        auto page_index = file_reader.GetPageIndexReader();
+        auto rg_page_index = page_index ? page_index->RowGroup(rg) : nullptr;
+        if (!rg_page_index) return offset_indexes;
+
+        offset_indexes.resize(file_reader.metadata()->num_columns());
+        for (int col : columns) {
+            offset_indexes[col] = rg_page_index->GetOffsetIndex(col);
+        }
+    }
+    catch (const std::exception&) {
+        offset_indexes.clear();
+    }
+    return offset_indexes;
+}
+
+// Pages des colonnes projetees ne contenant aucune ligne retenue
+std::vector<std::shared_ptr<const SkippedPages>> ColumnSkippedPages(const OffsetIndexes& offset_indexes,
+                                                                    const std::vector<int>& columns,
+                                                                    int64_t num_rows,
+                                                                    const IndexArray<RowRange>& selection) {
+    std::vector<std::shared_ptr<const SkippedPages>> pages(columns.size());
+    if (selection.empty() || offset_indexes.empty()) return pages;
+
+    for (size_t col = 0; col < columns.size(); col++) {
+        if (offset_indexes[columns[col]]) {
+            pages[col] = SkippedPages::Make(*offset_indexes[columns[col]], num_rows, selection.data(), selection.size());
+        }
+    }
+    return pages;
+}
+
+// Memorise les lignes retenues du row group : vide si toutes le sont, une plage vide si aucune
+void SetSelection(RowGroupIndex& rg_idx, const std::vector<RowRange>& ranges, int64_t num_rows) {
+    rg_idx.selection = IndexArray<RowRange>();
+    if (ranges.empty()) {
+        rg_idx.selection.push_back(RowRange{ 0, 0, 0 });
+    }
+    else if (ranges.size() > 1 || ranges[0].num_rows != num_rows) {
+        rg_idx.selection.reserve(ranges.size());
+        for (const RowRange& range : ranges) {
+            rg_idx.selection.push_back(range);
+        }
+    }
+}
+
+// Plages du fichier occupees par les column chunks des colonnes du row group, telles que lues par parquet
+std::vector<arrow::io::ReadRange> ColumnChunkRanges(const parquet::RowGroupMetaData& rg_metadata, const std::vector<int>& columns) {
+    std::vector<arrow::io::ReadRange> ranges;
+    ranges.reserve(columns.size());
+    for (int col : columns) {
+        auto chunk = rg_metadata.ColumnChunk(col);
+        ranges.push_back({ ColumnChunkStart(*chunk), chunk->total_compressed_size() });
+    }
+    return ranges;
+}
+
+} // namespace
+
+std::vector<int> ResolveColumns(const parquet::SchemaDescriptor& schema, const std::vector<std::string>& names) {
+    std::vector<int> columns;
+    if (names.empty()) {
+        columns.resize(schema.num_columns());
+        for (int col = 0; col < schema.num_columns(); col++) {
+            columns[col] = col;
+        }
+        return columns;
+    }
+
+    columns.reserve(names.size());
+    for (const std::string& name : names) {
+        int col = schema.ColumnIndex(name);
+        if (col < 0) throw std::runtime_error("Unknown column: " + name);
+        columns.push_back(col);
+    }
+    return columns;
+}
+
+std::vector<RowRange> RowGroupIndex::selectedRanges(int64_t first_row, int64_t num_rows) const {
+    if (selection.empty()) {
+        return { RowRange{ first_row, num_rows, first_row } };
+    }
+
+    std::vector<RowRange> ranges;
+    auto it = std::upper_bound(selection.begin(), selection.end(), first_row,
+        [](int64_t r, const RowRange& range) { return r < range.row; });
+    for (--it; num_rows > 0; ++it) {
+        const int64_t offset = first_row - it->row;
+        const int64_t count = std::min(it->num_rows - offset, num_rows);
+        ranges.push_back(RowRange{ it->first_row + offset, count, first_row });
+        first_row += count;
+        num_rows -= count;
+    }
+    return ranges;
+}
+
+uint64_t ParquetFile::BuildHeaderIndex(ParquetFileIndex& file_index) const {
     uint64_t global_offset = 0;
 
-    uint32_t num_row_groups = metadata->num_row_groups();
-    uint32_t num_columns = metadata->num_columns();
+    uint32_t num_columns = file_index.numColumns();
 
+    std::vector<HeaderIndex>& headers = file_index.headers;
     headers.clear();
+    if (!options.header) return global_offset;
     headers.reserve(num_columns);
 
     const parquet::SchemaDescriptor* schema = metadata->schema();
 
     for (uint32_t i = 0; i < num_columns; ++i) {
-        const parquet::ColumnDescriptor* col = schema->Column(i);
-        const auto& path = col->path()->ToDotString();
-        
+        const std::string path = i < file_index.columns.size() ? schema->Column(file_index.columns[i])->path()->ToDotString()
+                                                               : options.partition_columns[i - file_index.columns.size()].name;
+
         HeaderIndex header_idx;
         header_idx.col_index = i;
+        header_idx.name = path;
         header_idx.header_logical_start = global_offset;
 
         global_offset += path.size() + 1;
@@ -47,543 +204,742 @@ void ParquetFile::BuildLogicalIndex() {
         headers.push_back(header_idx);
     }
 
+    return global_offset;
+}
+
+void ParquetFile::BuildLogicalIndex(ParquetFileIndex& file_index) const {
+    if (!reader || !metadata)
+        throw std::runtime_error("Parquet reader or metadata not initialized");
+
+    uint64_t global_offset = BuildHeaderIndex(file_index);
+
+    uint32_t num_row_groups = metadata->num_row_groups();
+
+    std::vector<RowGroupIndex>& row_groups = file_index.row_groups;
     row_groups.clear();
-    row_groups.reserve(num_row_groups);
+    row_groups.resize(num_row_groups);
+
+    // Row groups et pages ecartes par le filtre, et index des offsets des pages, avant l'indexation
+    // parallele : la lecture de l'index des pages et des filtres de Bloom n'est pas thread-safe
+    std::vector<OffsetIndexes> offset_indexes(num_row_groups);
+    if (!file_index.filter.empty()) {
+        std::vector<int> read_columns = file_index.columns;
+        for (const Predicate& predicate : file_index.filter.predicates) {
+            read_columns.push_back(predicate.column);
+        }
 
-    auto parquet_reader = reader->parquet_reader();
+        parquet::ParquetFileReader& file_reader = *reader->parquet_reader();
+        for (uint32_t rg = 0; rg < num_row_groups; rg++) {
+            std::vector<RowRange> selection = file_index.filter.SelectRows(file_reader, rg);
+            SetSelection(row_groups[rg], selection, metadata->RowGroup(rg)->num_rows());
+            if (!selection.empty()) {
+                offset_indexes[rg] = ReadOffsetIndexes(file_reader, rg, read_columns);
+            }
+        }
+    }
 
-    for (uint32_t rg = 0; rg < num_row_groups; rg++)
-    {
-        RowGroupIndex rg_idx;
-        rg_idx.row_group_id = rg;
-        rg_idx.rowgroup_logical_start = global_offset;
-        rg_idx.columns.resize(num_columns);
-
-        auto rg_reader = parquet_reader->RowGroup(rg);
-        uint32_t num_rows = rg_reader->metadata()->num_rows();
-
-        // Ouvrir tous les ColumnReader en avance
-        std::vector<std::shared_ptr<parquet::ColumnReader>> col_readers(num_columns);
-        for (uint32_t col = 0; col < num_columns; col++) {
-            col_readers[col] = rg_reader->Column(col);
-            rg_idx.columns[col].column_id = col;
-            rg_idx.columns[col].column_logical_start = global_offset;
-
-            // Initialiser une page vide
-            PageIndex first_page;
-            first_page.page_index = 0;
-            first_page.page_logical_start = global_offset;
-            rg_idx.columns[col].pages.push_back(first_page);
-        }
-
-        // Lecture en mode row-major
-        for (uint32_t row = 0; row < num_rows; row++)
-        {
-            for (uint32_t col = 0; col < num_columns; col++)
-            {
-                auto phys = metadata->schema()->Column(col)->physical_type();
-                auto& col_reader = col_readers[col];
-
-                ValueIndex v;
-                v.row_index = row;
-                v.byte_len = 0;
-
-                std::vector<uint8_t> tmp;
-
-                // ---- Lire UNE SEULE VALEUR par colonne ----
-                int64_t values_read = 0;
-
-                switch (phys)
-                {
-                case parquet::Type::INT32: {
-                    int32_t val;
-                    auto typed = dynamic_cast<parquet::TypedColumnReader<parquet::Int32Type>*>(col_reader.get());
-                    typed->ReadBatch(1, nullptr, nullptr, &val, &values_read);
-                    std::string s = std::to_string(val);
-                    v.byte_len = s.size() + 1;
-                    break;
-                }
-
-                case parquet::Type::INT64: {
-                    int64_t val;
-                    auto typed = dynamic_cast<parquet::TypedColumnReader<parquet::Int64Type>*>(col_reader.get());
-                    typed->ReadBatch(1, nullptr, nullptr, &val, &values_read);
-                    std::string s = std::to_string(val);
-                    v.byte_len = s.size() + 1;
-                    break;
-                }
-
-                case parquet::Type::FLOAT: {
-                    float val;
-                    auto typed = dynamic_cast<parquet::TypedColumnReader<parquet::FloatType>*>(col_reader.get());
-                    typed->ReadBatch(1, nullptr, nullptr, &val, &values_read);
-                    std::string s = std::to_string(val);
-                    v.byte_len = s.size() + 1;
-                    break;
-                }
-
-                case parquet::Type::DOUBLE: {
-                    double val;
-                    auto typed = dynamic_cast<parquet::TypedColumnReader<parquet::DoubleType>*>(col_reader.get());
-                    typed->ReadBatch(1, nullptr, nullptr, &val, &values_read);
-                    std::string s = std::to_string(val);
-                    v.byte_len = s.size() + 1;
-                    break;
-                }
-
-                case parquet::Type::BYTE_ARRAY: {
-                    auto* typed =
-                        dynamic_cast<TypedColumnReader<parquet::ByteArrayType>*>(col_reader.get());
-                    if (!typed) throw std::runtime_error("Couldn't open ByteArray column reader");
-
-                    parquet::ByteArray value;
-                    int64_t values_read = 0;
-
-                    typed->ReadBatch(1, nullptr, nullptr, &value, &values_read);
-
-                    if (values_read <= 0 || value.ptr == nullptr || value.len == 0) {
-						v.byte_len = 1; // empty value but still need separator
-                        break;
-                    }
-                    else {
-                        const uint8_t* ptr = value.ptr;
-                        size_t len = value.len;
-
-                        bool need_quote = false;
-                        for (size_t i = 0; i < len; ++i) {
-                            char c = static_cast<char>(ptr[i]);
-                            if (c == '"' || c == '\n' || c == '\r' || c == sep) {
-                                need_quote = true;
-                                break;
-                            }
-                        }
-
-                        if (!need_quote) {
-                            v.byte_len = len;
-                        }
-                        else {
-                            v.byte_len++;
-                            for (size_t i = 0; i < len; ++i) {
-                                char c = static_cast<char>(ptr[i]);
-                                if (c == '"') {
-                                    v.byte_len++;
-                                }
-                            }
-                            v.byte_len += len;
-                            v.byte_len++;
-                        }
-                        v.byte_len += 1;
-                    }
-                    break;
-                }
-
-                /*case parquet::Type::FIXED_LEN_BYTE_ARRAY: {
-                    int32_t type_len = metadata->schema()->Column(col)->type_length();
-                    parquet::FixedLenByteArray flba;
-                    auto typed = dynamic_cast<parquet::TypedColumnReader<parquet::FixedLenByteArrayType>*>(col_reader.get());
-                    typed->ReadBatch(1, nullptr, nullptr, &flba, &values_read);
-                    v.byte_len = type_len;
-                    tmp.resize(v.byte_len);
-                    memcpy(tmp.data(), flba.ptr, type_len);
-                    break;
-                }*/
-
-                default:
-                    throw std::runtime_error("Unsupported type");
-                }
-
-                // Indexation logique
-                v.value_logical_start = global_offset;
-                v.value_logical_end = global_offset + v.byte_len - 1;
-
-                global_offset += v.byte_len;
-
-                // Ajouter dans la seule page existante
-                auto& col_idx = rg_idx.columns[col];
-                col_idx.pages.back().values.push_back(v);
+    // Chaque row group est indexe independamment, avec des offsets relatifs au debut du row group
+    unsigned num_threads = options.index_threads;
+    if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+    num_threads = std::min<unsigned>(num_threads, num_row_groups);
+
+    std::atomic<uint32_t> next_rg{ 0 };
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&]() {
+        uint32_t rg;
+        while ((rg = next_rg++) < num_row_groups) {
+            try {
+                BuildRowGroupIndex(rg, file_index.columns, file_index.partition_values, file_index.filter, offset_indexes[rg], row_groups[rg]);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+                next_rg = num_row_groups;
             }
         }
+    };
+
+    if (num_threads <= 1) {
+        worker();
+    }
+    else {
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads);
+        for (unsigned t = 0; t < num_threads; t++) {
+            threads.emplace_back(worker);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    if (error) std::rethrow_exception(error);
+
+    // Somme prefixe des tailles des row groups pour obtenir les offsets globaux
+    for (auto& rg_idx : row_groups) {
+        const uint64_t base = global_offset;
+        const uint64_t rg_size = rg_idx.rowgroup_logical_end + 1;
+
+        rg_idx.rowgroup_logical_start += base;
+        rg_idx.rowgroup_logical_end += base;
+        for (auto& offset : rg_idx.block_offsets) {
+            offset += base;
+        }
+        for (auto& block : rg_idx.blocks) {
+            block.block_logical_end += base;
+            for (auto& offset : block.row_offsets) {
+                offset += base;
+            }
+        }
+
+        global_offset += rg_size;
+    }
+
+    file_index.logical_size = global_offset;
+}
+
+void ParquetFile::BuildRowGroupIndex(uint32_t rg, const std::vector<int>& columns, const std::vector<std::string>& partition_values, const RowFilter& filter, const OffsetIndexes& offset_indexes, RowGroupIndex& rg_idx) const {
+    uint32_t num_columns = static_cast<uint32_t>(columns.size() + partition_values.size());
+
+    // Reader propre au row group, utilisable depuis un thread de travail
+    auto rg_reader = reader->parquet_reader()->RowGroup(rg);
+    int64_t num_rows = rg_reader->metadata()->num_rows();
+
+    // Evaluation du filtre ligne a ligne sur les pages qui n'ont pas ete ecartees
+    if (!filter.empty() && num_rows > 0 && (rg_idx.selection.empty() || rg_idx.selection[0].num_rows > 0)) {
+        std::vector<int> predicate_columns;
+        for (const Predicate& predicate : filter.predicates) {
+            predicate_columns.push_back(predicate.column);
+        }
+        adviseRowGroup(static_cast<int>(rg), predicate_columns, true);
+
+        std::vector<RowRange> ranges(rg_idx.selection.begin(), rg_idx.selection.end());
+        if (ranges.empty()) {
+            ranges.push_back(RowRange{ 0, num_rows, 0 });
+        }
+        SetSelection(rg_idx, filter.EvaluateRows(*rg_reader, std::move(ranges), offset_indexes), num_rows);
+        adviseRowGroup(static_cast<int>(rg), predicate_columns, false);
+    }
+    const std::vector<std::shared_ptr<const SkippedPages>> rg_pages = ColumnSkippedPages(offset_indexes, columns, num_rows, rg_idx.selection);
+
+    if (!rg_idx.selection.empty()) {
+        num_rows = rg_idx.selection[rg_idx.selection.size() - 1].row + rg_idx.selection[rg_idx.selection.size() - 1].num_rows;
+    }
+
+    // Index paresseux : un seul bloc par row group, dont seule la taille rendue est conservee
+    const bool dense = options.indexCheckpointRows() == 0;
+
+    rg_idx.row_group_id = rg;
+    rg_idx.num_rows = num_rows;
+    rg_idx.num_columns = num_columns;
+    rg_idx.rowgroup_logical_start = 0;
+    rg_idx.block_rows = options.checkpoint_rows > 0 ? options.checkpoint_rows : std::max<int64_t>(num_rows, 1);
+
+    std::vector<std::unique_ptr<ColumnLengths>> col_lengths;
+    if (num_rows > 0) {
+        adviseRowGroup(static_cast<int>(rg), columns, true);
+        col_lengths = OpenColumnLengths(*rg_reader, columns, partition_values, rg_pages);
+    }
+
+    // Index dense : un seul bloc conserve. Index creux : seul l'offset de chaque bloc est conserve.
+    uint64_t offset = 0;
+    RowBlockIndex block;
+    for (int64_t first_row = 0; first_row < num_rows; first_row += rg_idx.block_rows) {
+        const int64_t block_rows = std::min(rg_idx.block_rows, num_rows - first_row);
+        block.row_group_id = rg;
+        block.first_row = first_row;
+        DecodeRowBlock(col_lengths, rg_idx.selectedRanges(first_row, block_rows), block_rows, block);
+
+        rg_idx.block_offsets.push_back(offset);
+        for (auto& row_offset : block.row_offsets) {
+            row_offset += offset;
+        }
+        block.block_logical_end += offset;
+        offset = block.block_logical_end + 1;
+
+        if (dense) {
+            rg_idx.blocks.push_back(std::move(block));
+            block = RowBlockIndex();
+        }
+    }
+
+    rg_idx.rowgroup_logical_end = offset - 1;
+
+    if (num_rows > 0) {
+        col_lengths.clear();
+        adviseRowGroup(static_cast<int>(rg), columns, false);
+    }
+}
+
+void ParquetFile::DecodeRowBlock(std::vector<std::unique_ptr<ColumnLengths>>& col_lengths, const std::vector<RowRange>& ranges, int64_t num_rows, RowBlockIndex& block) const {
+    uint32_t num_columns = static_cast<uint32_t>(col_lengths.size());
+
+    // rendered lengths of the block, one array per column
+    std::vector<std::vector<uint64_t>> col_lens(num_columns);
+
+    // Decodage colonne par colonne, par batchs
+    for (uint32_t col = 0; col < num_columns; col++) {
+        col_lens[col].resize(num_rows);
+        col_lengths[col]->read(ranges.data(), ranges.size(), col_lens[col].data());
+    }
+
+    block.num_rows = num_rows;
+    block.num_columns = num_columns;
+    block.row_offsets.resize(num_rows);
+    block.cell_lengths = CellLengths();
+    block.cell_lengths.reserve(static_cast<uint64_t>(num_rows) * num_columns);
 
-        // Finaliser fin de pages et colonnes
+    // Indexation logique en mode row-major, offsets relatifs au debut du bloc
+    uint64_t offset = 0;
+    for (int64_t row = 0; row < num_rows; row++)
+    {
+        block.row_offsets[row] = offset;
         for (uint32_t col = 0; col < num_columns; col++)
         {
-            auto& c = rg_idx.columns[col];
-            c.pages.back().page_logical_end = global_offset - 1;
-            c.column_logical_end = global_offset - 1;
+            uint64_t len = col_lens[col][row];
+            block.cell_lengths.push_back(len);
+            offset += len;
         }
+    }
+
+    block.block_logical_end = offset - 1;
+}
+
+const RowBlockIndex& ParquetFile::getRowBlock(size_t rg, int64_t row) {
+    const RowGroupIndex& rg_idx = index->row_groups[rg];
+    size_t b = static_cast<size_t>(row / rg_idx.block_rows);
+
+    if (!rg_idx.blocks.empty()) {
+        return rg_idx.blocks[b];
+    }
+    if (block_cache && block_cache->contains(static_cast<int>(rg), row)) {
+        return *block_cache;
+    }
 
-        rg_idx.rowgroup_logical_end = global_offset - 1;
-        row_groups.push_back(rg_idx);
+    // Bloc deja decode par un handle du fichier
+    const int64_t first_row = static_cast<int64_t>(b) * rg_idx.block_rows;
+    const int64_t block_rows = std::min(rg_idx.block_rows, rg_idx.num_rows - first_row);
+    RowIndexCache& cache = RowIndexCache::instance();
+    block_cache = cache.get(index->file_key, static_cast<int>(rg), first_row, block_rows);
+    if (block_cache) {
+        return *block_cache;
     }
 
-    logical_size = global_offset;
+    // Index creux : on decode a nouveau les lignes du bloc pour retrouver leurs offsets,
+    // les lignes qui le precedent etant sautees
+    enterRowGroup(static_cast<int>(rg));
+    auto rg_reader = reader->parquet_reader()->RowGroup(static_cast<int>(rg));
+
+    // Les colonnes sont lues a partir de la page de la premiere ligne du bloc
+    const int64_t physical_first_row = rg_idx.physicalRow(first_row);
+    std::vector<PageSeek> seeks(index->columns.size());
+    for (uint32_t col = 0; col < index->columns.size(); col++) {
+        seeks[col] = pageSeek(rg, col, physical_first_row > 0);
+    }
+    std::vector<std::unique_ptr<ColumnLengths>> col_lengths = OpenColumnLengths(*rg_reader, index->columns, index->partition_values, skippedPages(rg), seeks, physical_first_row);
+
+    auto block = std::make_shared<RowBlockIndex>();
+    block->first_row = first_row;
+    DecodeRowBlock(col_lengths, rg_idx.selectedRanges(first_row, block_rows), block_rows, *block);
+
+    const uint64_t base = rg_idx.block_offsets[b];
+    for (auto& row_offset : block->row_offsets) {
+        row_offset += base;
+    }
+    block->block_logical_end += base;
+    block->row_group_id = static_cast<int>(rg);
+
+    const uint64_t block_memory = block->memoryUsage();
+    block_cache = std::move(block);
+    cache.put(index->file_key, static_cast<int>(rg), first_row, block_rows, block_cache, block_memory);
+    return *block_cache;
 }
 
+ParquetFileOptions ParquetFileOptions::FromEnvironment() {
+    ParquetFileOptions options;
 
+    const char* threads = std::getenv("KHIOPS_PARQUET_INDEX_THREADS");
+    if (threads != nullptr) {
+        options.index_threads = static_cast<unsigned>(std::strtoul(threads, nullptr, 10));
+    }
 
+    const char* checkpoint_rows = std::getenv("KHIOPS_PARQUET_CHECKPOINT_ROWS");
+    if (checkpoint_rows != nullptr) {
+        options.checkpoint_rows = std::strtoll(checkpoint_rows, nullptr, 10);
+    }
+
+    const char* lazy_index = std::getenv("KHIOPS_PARQUET_LAZY_INDEX");
+    if (lazy_index != nullptr) {
+        options.lazy_index = std::strtol(lazy_index, nullptr, 10) != 0;
+    }
+
+    const char* row_index_cache_bytes = std::getenv("KHIOPS_PARQUET_ROW_INDEX_CACHE_BYTES");
+    if (row_index_cache_bytes != nullptr) {
+        options.row_index_cache_bytes = std::strtoull(row_index_cache_bytes, nullptr, 10);
+    }
+
+    const char* cache_bytes = std::getenv("KHIOPS_PARQUET_CACHE_BYTES");
+    if (cache_bytes != nullptr) {
+        options.rowgroup_cache_bytes = std::strtoull(cache_bytes, nullptr, 10);
+    }
+
+    const char* cache_lz4 = std::getenv("KHIOPS_PARQUET_CACHE_LZ4");
+    if (cache_lz4 != nullptr) {
+        options.rowgroup_cache_lz4 = std::strtol(cache_lz4, nullptr, 10) != 0;
+    }
+
+    // Un repertoire de cache des index active les sidecars, sauf KHIOPS_PARQUET_SIDECAR_INDEX=0
+    const char* index_dir = std::getenv("KHIOPS_PARQUET_INDEX_DIR");
+    if (index_dir != nullptr && *index_dir != '\0') {
+        options.index_cache_dir = index_dir;
+        options.sidecar_index = true;
+    }
+
+    const char* sidecar = std::getenv("KHIOPS_PARQUET_SIDECAR_INDEX");
+    if (sidecar != nullptr) {
+        options.sidecar_index = std::strtol(sidecar, nullptr, 10) != 0;
+    }
+
+    const char* memory_map = std::getenv("KHIOPS_PARQUET_MMAP");
+    if (memory_map != nullptr) {
+        options.memory_map = std::strtol(memory_map, nullptr, 10) != 0;
+    }
+
+    const char* prefetch_row_groups = std::getenv("KHIOPS_PARQUET_PREFETCH_ROW_GROUPS");
+    if (prefetch_row_groups != nullptr) {
+        options.prefetch_row_groups = static_cast<int>(std::strtol(prefetch_row_groups, nullptr, 10));
+    }
+
+    const char* prefetch_bytes = std::getenv("KHIOPS_PARQUET_PREFETCH_BYTES");
+    if (prefetch_bytes != nullptr) {
+        options.prefetch_bytes = std::strtoull(prefetch_bytes, nullptr, 10);
+    }
+
+    return options;
+}
+
+ParquetFile::ParquetFile(const std::string& path, const ParquetFileOptions& options) : options(options) {
+    std::shared_ptr<arrow::io::RandomAccessFile> infile;
+    if (options.memory_map) {
+        arrow::Result<std::shared_ptr<arrow::io::MemoryMappedFile>> result = arrow::io::MemoryMappedFile::Open(path, arrow::io::FileMode::READ);
+        if (!result.ok()) {
+            throw std::runtime_error("Erreur lors de la projection du fichier en memoire.");
+        }
+        infile = result.ValueOrDie();
+
+        // Vue sans copie sur toute la projection, pour les indications de liberation des pages
+        PARQUET_ASSIGN_OR_THROW(int64_t size, infile->GetSize());
+        PARQUET_ASSIGN_OR_THROW(mapped_content, infile->ReadAt(0, size));
+    }
+    else {
+        arrow::Result<std::shared_ptr<arrow::io::ReadableFile>> result = arrow::io::ReadableFile::Open(path);
+        if (!result.ok()) {
+            throw std::runtime_error("Erreur lors de l'ouverture du fichier en lecture.");
+        }
+        infile = result.ValueOrDie();
+
+        if (options.prefetch_row_groups > 0 && options.prefetch_bytes > 0) {
+            prefetcher = std::make_shared<PrefetchingFile>(infile, options.prefetch_bytes);
+            infile = prefetcher;
+        }
+    }
+    input = infile;
 
-ParquetFile::ParquetFile(const std::string& path) {
-    arrow::Result<std::shared_ptr<arrow::io::ReadableFile>> result = arrow::io::ReadableFile::Open(path);
-    if (!result.ok()) {
-        throw std::runtime_error("Erreur lors de l'ouverture du fichier en lecture.");
+    if (options.rowgroup_cache_bytes > 0) {
+        RowGroupCache::instance().configure(options.rowgroup_cache_bytes, options.rowgroup_cache_lz4);
     }
+    if (options.indexCheckpointRows() != 0) {
+        RowIndexCache::instance().configure(options.row_index_cache_bytes);
+    }
+
+    // Identite du fichier : chemin, taille et date de modification
+    std::error_code size_ec, mtime_ec;
+    const uint64_t file_size = std::filesystem::file_size(path, size_ec);
+    const int64_t mtime = std::filesystem::last_write_time(path, mtime_ec).time_since_epoch().count();
+    const bool shareable = !size_ec && !mtime_ec;
+
+    // L'index depend aussi des options d'indexation, de la projection et du filtre
+    std::string projection;
+    for (const std::string& name : options.columns) {
+        projection += '|' + name;
+    }
+    if (!options.filter.empty()) {
+        projection += "|?" + options.filter;
+    }
+    for (const PartitionColumn& partition : options.partition_columns) {
+        projection += "|=" + partition.name + '=' + partition.value;
+    }
+    if (!options.header) {
+        projection += "|!header";
+    }
+    const int64_t checkpoint_rows = options.indexCheckpointRows();
+    const std::string registry_key = path + '|' + std::to_string(checkpoint_rows) + projection;
 
-    std::shared_ptr<arrow::io::ReadableFile> infile = result.ValueOrDie();
+    IndexRegistry& registry = IndexRegistry::instance();
+    if (shareable) {
+        index = registry.get(registry_key, file_size, mtime);
+    }
+
+    if (index) {
+        // Fichier deja indexe : seul un lecteur propre au handle est ouvert, sans relire le footer
+        metadata = index->metadata;
+        PARQUET_ASSIGN_OR_THROW(reader, parquet::arrow::FileReader::Make(arrow::default_memory_pool(),
+            parquet::ParquetFileReader::Open(infile, parquet::default_reader_properties(), metadata)));
+        return;
+    }
 
     PARQUET_ASSIGN_OR_THROW(reader, parquet::arrow::OpenFile(infile, arrow::default_memory_pool()));
 
     metadata = reader->parquet_reader()->metadata();
 
-    BuildLogicalIndex();
+    auto file_index = std::make_shared<ParquetFileIndex>();
+    file_index->metadata = metadata;
+    file_index->columns = ResolveColumns(*metadata->schema(), options.columns);
+    file_index->filter = RowFilter::Parse(options.filter, *metadata->schema());
+    for (const PartitionColumn& partition : options.partition_columns) {
+        const parquet::ByteArray value(static_cast<uint32_t>(partition.value.size()), reinterpret_cast<const uint8_t*>(partition.value.data()));
+        std::string text(FormattedLength(value), '\0');
+        FormatValue(value, reinterpret_cast<uint8_t*>(text.data()));
+        file_index->partition_values.push_back(std::move(text));
+    }
+    file_index->file_key = path + '|' + std::to_string(file_size) + '|' + std::to_string(mtime) + projection;
+
+    if (!options.sidecar_index) {
+        BuildLogicalIndex(*file_index);
+    }
+    else {
+        // Index persistant : projete en memoire s'il correspond au fichier, sinon construit puis ecrit
+        const SidecarKey key = SidecarKey::Make(*infile, mtime, checkpoint_rows, *metadata, file_index->columns, file_index->numColumns(), projection);
+        const std::string sidecar_path = SidecarIndexPath(path, options.index_cache_dir, projection);
+
+        const uint64_t data_start = BuildHeaderIndex(*file_index);
+        file_index->sidecar_buffer = LoadSidecarIndex(sidecar_path, key, data_start, file_index->logical_size, file_index->row_groups);
+        if (!file_index->sidecar_buffer) {
+            BuildLogicalIndex(*file_index);
+            WriteSidecarIndex(sidecar_path, key, file_index->logical_size, file_index->row_groups);
+        }
+    }
+
+    index = shareable ? registry.put(registry_key, file_size, mtime, std::move(file_index)) : std::move(file_index);
 }
 
 ParquetFile::~ParquetFile() {}
 
 void ParquetFile::dumpInfo() {
     std::cout << "Dump of ParquetFile" << std::endl;
-    std::cout << "logical size : " + logical_size << std::endl;
-    std::cout << "logical pos : " + pos << std::endl;
-    for (size_t rg = 0; rg < this->row_groups.size(); rg++) {
-        RowGroupIndex rg_idx = row_groups[rg];
+    std::cout << "logical size : " << index->logical_size << std::endl;
+    std::cout << "logical pos : " << pos << std::endl;
+    for (size_t rg = 0; rg < index->row_groups.size(); rg++) {
+        const RowGroupIndex& rg_idx = index->row_groups[rg];
+
+        uint64_t index_memory = rg_idx.block_offsets.capacity() * sizeof(uint64_t);
+        for (const RowBlockIndex& block : rg_idx.blocks) {
+            index_memory += block.memoryUsage();
+        }
 
-        for (size_t col = 0; col < rg_idx.columns.size(); col++) {
-            ColumnIndex col_idx = rg_idx.columns[col];
+        std::cout << "    Dump of RowGroupIndex: (rg: " << rg << ")" << std::endl;
+        std::cout << "    rows: " << rg_idx.num_rows << " (" << rg_idx.block_offsets.size() << " blocks)" << std::endl;
+        std::cout << "    row group logical start: " << rg_idx.rowgroup_logical_start << std::endl;
+        std::cout << "    row group logical end: " << rg_idx.rowgroup_logical_end << std::endl;
+        std::cout << "    index memory: " << index_memory << " bytes" << std::endl;
 
-            for (size_t page = 0; page < col_idx.pages.size(); page++) {
-                PageIndex page_idx = col_idx.pages[page];
+        for (int64_t row = 0; row < rg_idx.num_rows; row++) {
+            const RowBlockIndex& block = getRowBlock(rg, row);
+            uint64_t value_start = block.rowStart(row);
 
-                for (size_t val = 0; val < page_idx.values.size(); val++) {
-                    ValueIndex val_idx = page_idx.values[val];
+            for (uint32_t col = 0; col < rg_idx.num_columns; col++) {
+                uint64_t len = block.cellLength(row, col);
 
-                    std::cout << "            Dump of ValueIndex: (rg: " << rg << ")-(col: " << col << ")-(page: " << page << ")-(val: " << val << ")" << std::endl;
-                    std::cout << "            value row index in row group: " << val_idx.row_index << std::endl;
-                    std::cout << "            value logical start: " << val_idx.value_logical_start << std::endl;
-                    std::cout << "            value logical end: " << val_idx.value_logical_end << std::endl;
-                    std::cout << "            value logical size: " << val_idx.byte_len << std::endl;
-                    std::cout << "            -------------------" << std::endl;
+                std::cout << "            Dump of value: (rg: " << rg << ")-(row: " << row << ")-(col: " << col << ")" << std::endl;
+                std::cout << "            value logical start: " << value_start << std::endl;
+                std::cout << "            value logical end: " << value_start + len - 1 << std::endl;
+                std::cout << "            value logical size: " << len << std::endl;
+                std::cout << "            -------------------" << std::endl;
 
-                }
+                value_start += len;
             }
         }
     }
 }
 
-bool ParquetFile::findValueAtLogicalPosition(size_t& out_row_group, size_t& out_column, size_t& out_page, size_t& out_value, size_t& out_header)
+bool ParquetFile::findValueAtLogicalPosition(size_t& out_row_group, int64_t& out_row, size_t& out_column, uint64_t& out_value_start, size_t& out_header)
 {
-    if (this->pos >= 0 && this->pos <= headers.back().header_logical_end) {
-        for (size_t col = 0; col < this->headers.size(); col++) {
-            if (this->pos >= headers[col].header_logical_start && pos <= headers[col].header_logical_end) {
-                out_header = col;
-                return true;
-            }
-        }
+    const std::vector<HeaderIndex>& headers = index->headers;
+    const std::vector<RowGroupIndex>& row_groups = index->row_groups;
+
+    // Toutes les recherches sont dichotomiques : dernier element dont le debut est <= pos
+    if (!headers.empty() && this->pos <= headers.back().header_logical_end) {
+        auto it = std::upper_bound(headers.begin(), headers.end(), this->pos,
+            [](uint64_t pos, const HeaderIndex& h) { return pos < h.header_logical_start; });
+        if (it == headers.begin()) return false;
+        out_header = static_cast<size_t>(std::distance(headers.begin(), it) - 1);
+        return true;
+    }
+
+    auto rg_it = std::upper_bound(row_groups.begin(), row_groups.end(), this->pos,
+        [](uint64_t pos, const RowGroupIndex& rg_idx) { return pos < rg_idx.rowgroup_logical_start; });
+    if (rg_it == row_groups.begin()) return false;
+    --rg_it;
+
+    const RowGroupIndex& rg_idx = *rg_it;
+    if (rg_idx.num_rows == 0 || this->pos > rg_idx.rowgroup_logical_end) {
         return false;
     }
-    for (size_t rg = 0; rg < this->row_groups.size(); rg++) {
-        RowGroupIndex& rg_idx = row_groups[rg];
-        if (this->pos < rg_idx.rowgroup_logical_start || this->pos > rg_idx.rowgroup_logical_end) {
-            continue;
+
+    // found row group
+    const size_t rg = static_cast<size_t>(std::distance(row_groups.begin(), rg_it));
+    out_row_group = rg;
+
+    auto block_it = std::upper_bound(rg_idx.block_offsets.begin(), rg_idx.block_offsets.end(), this->pos);
+    if (block_it == rg_idx.block_offsets.begin()) return false;
+
+    // found block
+    const int64_t b = std::distance(rg_idx.block_offsets.begin(), block_it) - 1;
+    const RowBlockIndex& block = getRowBlock(rg, b * rg_idx.block_rows);
+
+    auto row_it = std::upper_bound(block.row_offsets.begin(), block.row_offsets.end(), this->pos);
+    if (row_it == block.row_offsets.begin()) return false;
+
+    // found row
+    const int64_t row = block.first_row + std::distance(block.row_offsets.begin(), row_it) - 1;
+    out_row = row;
+
+    uint64_t value_start = block.rowStart(row);
+    for (uint32_t col = 0; col < rg_idx.num_columns; col++) {
+        uint64_t len = block.cellLength(row, col);
+        if (this->pos < value_start + len) {
+            // found value
+            out_column = col;
+            out_value_start = value_start;
+            return true;
+        }
+        value_start += len;
+    }
+    return false;
+}
+
+uint64_t ParquetFile::rowAlignedOffset(uint64_t target, uint64_t tolerance) {
+    const std::vector<HeaderIndex>& headers = index->headers;
+    const std::vector<RowGroupIndex>& row_groups = index->row_groups;
+
+    const uint64_t data_start = headers.empty() ? 0 : headers.back().header_logical_end + 1;
+    if (target == 0) return 0;
+    if (target <= data_start) return data_start;
+    if (target >= index->logical_size) return index->logical_size;
+
+    // Row group contenant target, les row groups vides etant sautes
+    auto rg_it = std::upper_bound(row_groups.begin(), row_groups.end(), target,
+        [](uint64_t pos, const RowGroupIndex& rg_idx) { return pos < rg_idx.rowgroup_logical_start; });
+    --rg_it;
+    const RowGroupIndex& rg_idx = *rg_it;
+
+    // Les colonnes sont lues sans saut de pages a partir du debut d'un row group
+    const uint64_t rg_start = rg_idx.rowgroup_logical_start;
+    const uint64_t rg_next = rg_idx.rowgroup_logical_end + 1;
+    if (std::min(target - rg_start, rg_next - target) <= tolerance) {
+        return target - rg_start <= rg_next - target ? rg_start : rg_next;
+    }
+
+    const size_t rg = static_cast<size_t>(std::distance(row_groups.begin(), rg_it));
+    auto block_it = std::upper_bound(rg_idx.block_offsets.begin(), rg_idx.block_offsets.end(), target);
+    const int64_t b = std::distance(rg_idx.block_offsets.begin(), block_it) - 1;
+    const RowBlockIndex& block = getRowBlock(rg, b * rg_idx.block_rows);
+
+    auto row_it = std::upper_bound(block.row_offsets.begin(), block.row_offsets.end(), target);
+    const int64_t row = block.first_row + std::distance(block.row_offsets.begin(), row_it) - 1;
+    return block.rowStart(row) == target ? target : block.rowEnd(row) + 1;
+}
+
+uint64_t ParquetFile::rowOffset(int64_t row) {
+    const std::vector<RowGroupIndex>& row_groups = index->row_groups;
+    for (size_t rg = 0; rg < row_groups.size(); rg++) {
+        if (row < row_groups[rg].num_rows) {
+            return getRowBlock(rg, row).rowStart(row);
         }
+        row -= row_groups[rg].num_rows;
+    }
+    return index->logical_size;
+}
 
-        // found row group
-        out_row_group = rg_idx.row_group_id;
+void ParquetFile::adviseRowGroup(int rg, const std::vector<int>& columns, bool will_need) const {
+    if (!mapped_content) return;
 
-        for (size_t col = 0; col < rg_idx.columns.size(); col++) {
-            ColumnIndex& col_idx = rg_idx.columns[col];
-            if (this->pos < col_idx.column_logical_start || this->pos > col_idx.column_logical_end) {
-                continue;
-            }
+    const std::vector<arrow::io::ReadRange> ranges = ColumnChunkRanges(*metadata->RowGroup(rg), columns);
+
+    // Les column chunks sont lus en entier a l'ouverture de leur reader : leurs pages sont
+    // chargees d'avance plutot qu'a chaque defaut de page
+    if (will_need) {
+        input->WillNeed(ranges).ok();
+        return;
+    }
+
+#ifndef _WIN32
+    // Pages entierement comprises dans les column chunks lus, qui restent dans le cache du systeme
+    const int64_t page_size = sysconf(_SC_PAGESIZE);
+    uint8_t* base = const_cast<uint8_t*>(mapped_content->data());
+    for (const arrow::io::ReadRange& range : ranges) {
+        const int64_t start = (range.offset + page_size - 1) / page_size * page_size;
+        const int64_t end = std::min(range.offset + range.length, mapped_content->size()) / page_size * page_size;
+        if (end > start) {
+            madvise(base + start, static_cast<size_t>(end - start), MADV_DONTNEED);
+        }
+    }
+#endif
+}
 
-            // found column
-            out_column = col_idx.column_id;
-
-            for (size_t page = 0; page < col_idx.pages.size(); page++) {
-                PageIndex& page_idx = col_idx.pages[page];
-                if (this->pos < page_idx.page_logical_start || this->pos > page_idx.page_logical_end) {
-                    continue;
-                }
-
-                // found page
-                out_page = page_idx.page_index;
-
-                for (size_t val = 0; val < page_idx.values.size(); val++) {
-                    ValueIndex& val_idx = page_idx.values[val];
-                    if (this->pos >= val_idx.value_logical_start && this->pos <= val_idx.value_logical_end) {
-                        // found value
-                        out_value = val;
-                        return true;
-                    }
-                }
+void ParquetFile::prefetchRowGroups(int rg, bool sequential) {
+    if (!prefetcher) return;
+
+    // Seule une lecture sequentielle est anticipee : apres un saut, seuls les column chunks deja
+    // demandes du row group courant sont conserves
+    std::vector<int> ahead;
+    if (sequential || prefetcher->prefetched(rg)) {
+        const int num_row_groups = static_cast<int>(index->row_groups.size());
+        for (int next = rg + 1; next < num_row_groups && static_cast<int>(ahead.size()) < options.prefetch_row_groups; next++) {
+            if (index->row_groups[next].num_rows > 0) {
+                ahead.push_back(next);
             }
         }
-	}
-    return false;
+    }
+    prefetcher->retain(rg, ahead.empty() ? rg + 1 : ahead.back() + 1);
+
+    for (int next : ahead) {
+        if (!prefetcher->prefetched(next) && !prefetcher->prefetch(next, ColumnChunkRanges(*metadata->RowGroup(next), index->columns))) break;
+    }
 }
 
-bool ParquetFile::readHeader(size_t header, std::string& out_bytes) {
-    const parquet::ColumnDescriptor* col = this->metadata->schema()->Column(header);
-    std::string value = col->path()->ToDotString();
-    if (header == this->headers.size() - 1) {
-        value.push_back('\n');
+void ParquetFile::prefetchStart() {
+    if (advised_rg < 0) {
+        prefetchRowGroups(-1, true);
     }
-    else {
-        value.push_back(sep);
+}
+
+void ParquetFile::enterRowGroup(int rg) {
+    if (advised_rg == rg) return;
+    if (advised_rg >= 0) {
+        adviseRowGroup(advised_rg, index->columns, false);
     }
-    out_bytes = value;
-    return true;
+    adviseRowGroup(rg, index->columns, true);
+    prefetchRowGroups(rg, rg == advised_rg + 1);
+    advised_rg = rg;
 }
 
-bool ParquetFile::readValue(int rg, int col, int page, int value, std::vector<uint8_t>& out_bytes)
-{
-    if (!this->reader) return false;
+const OffsetIndexes& ParquetFile::offsetIndexes(size_t rg) {
+    if (offset_indexes_rg != static_cast<int>(rg)) {
+        offset_indexes = ReadOffsetIndexes(*reader->parquet_reader(), static_cast<int>(rg), index->columns);
+        offset_indexes_rg = static_cast<int>(rg);
+    }
+    return offset_indexes;
+}
 
-    parquet::ParquetFileReader* pq_reader = this->reader->parquet_reader();
-    if (!pq_reader) return false;
+const std::vector<std::shared_ptr<const SkippedPages>>& ParquetFile::skippedPages(size_t rg) {
+    if (pages_rg != static_cast<int>(rg)) {
+        const RowGroupIndex& rg_idx = index->row_groups[rg];
+        pages = ColumnSkippedPages(rg_idx.selection.empty() ? OffsetIndexes() : offsetIndexes(rg), index->columns,
+                                   metadata->RowGroup(static_cast<int>(rg))->num_rows(), rg_idx.selection);
+        pages_rg = static_cast<int>(rg);
+    }
+    return pages;
+}
 
-    auto rg_reader = pq_reader->RowGroup(rg);
-    if (!rg_reader) return false;
+PageSeek ParquetFile::pageSeek(size_t rg, uint32_t col, bool use_offset_index) {
+    PageSeek seek;
+    seek.file = input;
+    if (use_offset_index || !index->row_groups[rg].selection.empty()) {
+        const OffsetIndexes& column_indexes = offsetIndexes(rg);
+        if (!column_indexes.empty()) {
+            seek.offset_index = column_indexes[index->columns[col]];
+        }
+    }
+    return seek;
+}
 
-    auto col_reader = rg_reader->Column(col);
-    if (!col_reader) return false;
+bool ParquetFile::useRowGroupCache() const {
+    return options.rowgroup_cache_bytes > 0;
+}
 
-    parquet::Type::type phys = this->metadata->schema()->Column(col)->physical_type();
+RowGroupCache::Text ParquetFile::getRowGroupText(size_t rg) {
+    if (rowgroup_text && rowgroup_text_rg == static_cast<int>(rg)) {
+        return rowgroup_text;
+    }
 
-    ValueIndex to_read = this->row_groups[rg].columns[col].pages[page].values[value];
+    RowGroupCache& cache = RowGroupCache::instance();
+    RowGroupCache::Text text = cache.get(index->file_key, static_cast<int>(rg));
+    if (!text) {
+        // Rendu complet du row group, puis insertion dans le cache
+        const RowGroupIndex& rg_idx = index->row_groups[rg];
+        auto bytes = std::make_shared<std::vector<uint8_t>>(rg_idx.rowgroup_logical_end + 1 - rg_idx.rowgroup_logical_start);
+        uint8_t* out = bytes->data();
+        for (int64_t row = 0; row < rg_idx.num_rows; row++) {
+            const RowBlockIndex& block = getRowBlock(rg, row);
+            for (uint32_t col = 0; col < rg_idx.num_columns; col++) {
+                uint64_t len = block.cellLength(row, col);
+                if (!renderValue(rg, col, row, len, out)) return nullptr;
+                out += len;
+            }
+        }
+        text = bytes;
+        cache.put(index->file_key, static_cast<int>(rg), text);
+    }
+
+    rowgroup_text = text;
+    rowgroup_text_rg = static_cast<int>(rg);
+    return text;
+}
+
+bool ParquetFile::renderHeader(size_t header, uint8_t* out) const {
+    const std::string& name = index->headers[header].name;
+    std::memcpy(out, name.data(), name.size());
+    out[name.size()] = header == index->headers.size() - 1 ? '\n' : sep;
+    return true;
+}
 
-    int64_t to_skip = static_cast<int64_t>(to_read.row_index);
+bool ParquetFile::renderValue(size_t rg, uint32_t col, int64_t row, uint64_t len, uint8_t* out)
+{
+    if (!this->reader) return false;
 
-    int64_t values_read = 0;
+    // Colonne de partition : meme valeur sur toutes les lignes du fichier
+    if (col >= index->columns.size()) {
+        const std::string& value = index->partition_values[col - index->columns.size()];
+        if (value.size() != len - 1) return false;
+        std::memcpy(out, value.data(), value.size());
+        out[len - 1] = col == index->numColumns() - 1 ? '\n' : sep;
+        return true;
+    }
 
     try {
-        switch (phys) {
-            case Type::BOOLEAN: {
-                auto* typed = dynamic_cast<TypedColumnReader<parquet::BooleanType>*>(col_reader.get());
-                if (!typed) return false;
-                if (to_skip > 0) typed->Skip(to_skip);
-                bool val;
-                int64_t read = typed->ReadBatch(1, nullptr, nullptr, &val, &values_read);
-                if (values_read <= 0) { // NULL or nothing
-                    out_bytes.clear();
-                    return true;
-                }
-                std::string s = std::to_string(val);
-                out_bytes.resize(s.size());
-                std::memcpy(out_bytes.data(), s.data(), s.size());
-                if (col == this->metadata->num_columns() - 1) {
-                    out_bytes.push_back('\n');
-                }
-                else {
-                    out_bytes.push_back(sep);
-                }
-
-                return true;
-			}
-            case Type::INT32: {
-                auto* typed = dynamic_cast<TypedColumnReader<parquet::Int32Type>*>(col_reader.get());
-                if (!typed) return false;
-                
-                if (to_skip > 0) typed->Skip(to_skip);
-                
-                int32_t val;
-                int64_t read = typed->ReadBatch(1, nullptr, nullptr, &val, &values_read);
-                if (values_read <= 0) { // NULL or nothing
-                    out_bytes.clear(); 
-                    return true;
-                }
-                std::string s = std::to_string(val);
-                out_bytes.resize(s.size());
-                std::memcpy(out_bytes.data(), s.data(), s.size());
-                if (col == this->metadata->num_columns() - 1) {
-                    out_bytes.push_back('\n');
-                }
-                else {
-                    out_bytes.push_back(sep);
-                }
-
-                return true;
-            }
-            case Type::INT64: {
-                auto* typed = dynamic_cast<TypedColumnReader<parquet::Int64Type>*>(col_reader.get());
-                if (!typed) return false;
-                
-                if (to_skip > 0) typed->Skip(to_skip);
-
-                int64_t val;
-                int64_t read = typed->ReadBatch(1, nullptr, nullptr, &val, &values_read);
-                if (values_read <= 0) {
-                    out_bytes.clear();
-                    return true;
-                }
-                std::string s = std::to_string(val);
-                out_bytes.resize(s.size());
-                std::memcpy(out_bytes.data(), s.data(), s.size());
-                if (col == this->metadata->num_columns() - 1) {
-                    out_bytes.push_back('\n');
-                }
-                else {
-                    out_bytes.push_back(sep);
-                }
-
-                return true;
-            }
-            /*case Type::INT96: {
-                auto* typed = dynamic_cast<TypedColumnReader<parquet::Int96Type>*>(col_reader.get());
-                if (!typed) return false;
-                
-                if (to_skip > 0) typed->Skip(to_skip);
-                
-                parquet::Int96 val;
-                int64_t read = typed->ReadBatch(1, nullptr, nullptr, &val, &values_read);
-                if (values_read <= 0) {
-                    out_bytes.clear();
-                    return true;
-                }
-                std::string s = std::to_string(val).append(sep);
-                out_bytes.resize(s.size());
-                std::memcpy(out_bytes.data(), s.data(), s.size());
-                
-                return true;
-			}*/
-            case Type::FLOAT: {
-                auto* typed = dynamic_cast<TypedColumnReader<parquet::FloatType>*>(col_reader.get());
-                if (!typed) return false;
-                
-                if (to_skip > 0) typed->Skip(to_skip);
-                
-                float val;
-                int64_t read = typed->ReadBatch(1, nullptr, nullptr, &val, &values_read);
-                if (values_read <= 0) {
-                    out_bytes.clear();
-                    return true;
-                }
-                std::string s = std::to_string(val);
-                out_bytes.resize(s.size());
-                std::memcpy(out_bytes.data(), s.data(), s.size());
-                if (col == this->metadata->num_columns() - 1) {
-                    out_bytes.push_back('\n');
-                }
-                else {
-                    out_bytes.push_back(sep);
-                }
-                
-                return true;
-            }
-            case Type::DOUBLE: {
-                auto* typed = dynamic_cast<TypedColumnReader<parquet::DoubleType>*>(col_reader.get());
-                if (!typed) return false;
-                
-                if (to_skip > 0) typed->Skip(to_skip);
-                
-                double val;
-                int64_t read = typed->ReadBatch(1, nullptr, nullptr, &val, &values_read);
-                if (values_read <= 0) {
-                    out_bytes.clear();
-                    return true;
-                }
-                std::string s = std::to_string(val);
-                out_bytes.resize(s.size());
-                std::memcpy(out_bytes.data(), s.data(), s.size());
-                if (col == this->metadata->num_columns() - 1) {
-                    out_bytes.push_back('\n');
-                }
-                else {
-                    out_bytes.push_back(sep);
-                }
-
-                return true;
-            }
-            case Type::BYTE_ARRAY: {
-                auto* typed =
-                    dynamic_cast<TypedColumnReader<parquet::ByteArrayType>*>(col_reader.get());
-                if (!typed) return false;
-
-                if (to_skip > 0) {
-                    typed->Skip(to_skip);
-                }
-
-                parquet::ByteArray value;
-                int64_t values_read = 0;
-
-                typed->ReadBatch(1, nullptr, nullptr, &value, &values_read);
-
-                if (values_read <= 0 || value.ptr == nullptr || value.len == 0) {
-                }
-                else {
-                    const uint8_t* ptr = value.ptr;
-                    size_t len = value.len;
-
-                    bool need_quote = false;
-                    for (size_t i = 0; i < len; ++i) {
-                        char c = static_cast<char>(ptr[i]);
-                        if (c == '"' || c == '\n' || c == '\r' || c == sep) {
-                            need_quote = true;
-                            break;
-                        }
-                    }
-
-                    if (need_quote) {
-                        out_bytes.reserve(out_bytes.size() + len * 2 + 2);
-                    }
-                    else {
-                        out_bytes.reserve(out_bytes.size() + len);
-                    }
-
-                    if (!need_quote) {
-                        out_bytes.insert(out_bytes.end(), ptr, ptr + len);
-                    }
-                    else {
-                        out_bytes.push_back('"');
-                        for (size_t i = 0; i < len; ++i) {
-                            char c = static_cast<char>(ptr[i]);
-                            if (c == '"') {
-                                out_bytes.push_back('"');
-                            }
-                            out_bytes.push_back(c);
-                        }
-                        out_bytes.push_back('"');
-                    }
-                }
-
-                if (col == this->metadata->num_columns() - 1) {
-                    out_bytes.push_back('\n');
-                }
-                else {
-                    out_bytes.push_back(sep);
-                }
-
-                return true;
-            }
+        // Les curseurs de colonnes sont conserves tant qu'on lit dans le meme row group
+        if (static_cast<int>(rg) != cursor_rg) {
+            cursor_rg = -1;
+            cursors.clear();
+            cursors.resize(index->columns.size());
+            cursor_rg_reader = this->reader->parquet_reader()->RowGroup(static_cast<int>(rg));
+            cursor_rg = static_cast<int>(rg);
+            enterRowGroup(cursor_rg);
+        }
+
+        if (static_cast<int>(rg) != last_rg || row != last_row) {
+            last_physical_row = index->row_groups[rg].physicalRow(row);
+            last_rg = static_cast<int>(rg);
+            last_row = row;
+        }
 
-            /*case Type::FIXED_LEN_BYTE_ARRAY: {
-                auto* typed = dynamic_cast<TypedColumnReader<parquet::ByteArrayType>*>(col_reader.get());
-                if (!typed) return false;
-                
-                if (to_skip > 0) typed->Skip(to_skip);
-                
-                int32_t type_len = this->metadata->schema()->Column(col)->type_length();
-                
-                std::vector<parquet::FixedLenByteArray> buf(1);
-                int64_t read = typed->ReadBatch(1, nullptr, nullptr, buf.data(), &values_read);
-                if (values_read <= 0) {
-                    out_bytes.clear();
-                    return true;
-                }
-                
-                out_bytes.resize(type_len);
-                if (type_len > 0 && buf[0].ptr != nullptr)
-                    std::memcpy(out_bytes.data(), buf[0].ptr, type_len);
-                return true;
-			}*/
-            default:
-                // unsupported type
-                std::cout << "ParquetFile::ReadValue: Unsupported type" << std::endl;
-                return false;
+        // Une colonne ouverte au-dela de sa premiere ligne est lue a partir de la page de la ligne
+        auto& cursor = cursors[col];
+        if (!cursor) {
+            cursor = ColumnCursor::Make(cursor_rg_reader, index->columns[col], skippedPages(rg)[col], pageSeek(rg, col, last_physical_row > 0));
         }
+
+        // La taille ecrite doit correspondre a celle de l'index
+        if (cursor->writeValue(last_physical_row, out) != static_cast<int64_t>(len) - 1) return false;
     }
     catch (...) {
+        cursor_rg = -1;
         return false;
     }
 
-    return false;
+    out[len - 1] = col == index->numColumns() - 1 ? '\n' : sep;
+    return true;
 }
-
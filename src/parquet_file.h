@@ -1,6 +1,9 @@
 ﻿#pragma once
 
 #include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 #include <cstdint>
 #include <iostream>
@@ -12,49 +15,248 @@
 #include <parquet/arrow/reader.h>
 #include <parquet/api/reader.h>
 
+#include "column_cursor.h"
+#include "prefetching_file.h"
+#include "row_filter.h"
+#include "rowgroup_cache.h"
+#include "row_index_cache.h"
+
 struct HeaderIndex {
     uint32_t col_index;
+    std::string name;
 
     uint64_t header_logical_start;
     uint64_t header_logical_end;
 };
 
 
-struct ValueIndex {
-    uint32_t row_index;             // index de la ligne dans le row group
+// Tableau de l'index : possede ses valeurs pendant la construction, ou les lit
+// directement dans un index persistant projete en memoire (lecture seule)
+template <typename T>
+class IndexArray {
 
-    uint64_t value_logical_start;   // Position logique globale (en bytes)
-    uint64_t value_logical_end;     // logical_offset_start + byte_len - 1
+    public:
+        size_t size() const { return view ? view_size : owned.size(); }
+        bool empty() const { return size() == 0; }
+        size_t capacity() const { return view ? 0 : owned.capacity(); }
+
+        const T* data() const { return view ? view : owned.data(); }
+        const T* begin() const { return data(); }
+        const T* end() const { return data() + size(); }
+        const T& operator[](size_t i) const { return data()[i]; }
+
+        // Acces en ecriture, uniquement sur un tableau possede
+        T* begin() { return owned.data(); }
+        T* end() { return owned.data() + owned.size(); }
+        T& operator[](size_t i) { return owned[i]; }
+
+        void push_back(const T& value) { owned.push_back(value); }
+        void resize(size_t n) { owned.resize(n); }
+        void reserve(size_t n) { owned.reserve(n); }
+
+        void assignView(const T* ptr, size_t n) {
+            owned = std::vector<T>();
+            view = ptr;
+            view_size = n;
+        }
 
-    uint32_t byte_len;              // taille brute de la valeur après décodage
+    private:
+        std::vector<T> owned;
+        const T* view = nullptr;
+        size_t view_size = 0;
+};
 
+// Rendered lengths of the cells of a row group, in row-major order.
+// Lengths are stored on 16 bits; longer values are kept in an escape table.
+struct CellLengths {
+    static constexpr uint16_t kLongLength = 0xFFFF;
+
+    struct LongLength {
+        uint64_t cell;
+        uint64_t length;
+    };
+
+    IndexArray<uint16_t> lengths;           // one entry per cell
+    IndexArray<LongLength> long_lengths;    // lengths >= kLongLength, sorted by cell
+
+    void reserve(uint64_t num_cells) { lengths.reserve(num_cells); }
+
+    void push_back(uint64_t len) {
+        if (len >= kLongLength) {
+            long_lengths.push_back({ lengths.size(), len });
+            lengths.push_back(kLongLength);
+        }
+        else {
+            lengths.push_back(static_cast<uint16_t>(len));
+        }
+    }
+
+    uint64_t operator[](uint64_t cell) const {
+        uint16_t len = lengths[cell];
+        if (len != kLongLength) return len;
+        auto it = std::lower_bound(long_lengths.begin(), long_lengths.end(), cell,
+            [](const LongLength& l, uint64_t c) { return l.cell < c; });
+        if (it == long_lengths.end() || it->cell != cell) throw std::runtime_error("Missing long cell length");
+        return it->length;
+    }
+
+    uint64_t memoryUsage() const {
+        return lengths.capacity() * sizeof(uint16_t) + long_lengths.capacity() * sizeof(LongLength);
+    }
 };
 
-struct PageIndex {
-    uint32_t page_index;            // numéro de la page dans la colonne
+// Index detaille d'un bloc de lignes consecutives d'un row group
+struct RowBlockIndex {
+    int row_group_id = -1;
+    int64_t first_row = 0;              // index de la premiere ligne du bloc dans le row group
+    int64_t num_rows = 0;
+    uint32_t num_columns = 0;
 
-    uint64_t page_logical_start;    // offset logique global du début de la page
-    uint64_t page_logical_end;      // offset logique global de la fin de la page
+    uint64_t block_logical_end = 0;
 
-    std::vector<ValueIndex> values; // index des valeurs présentes dans la page
-};
+    IndexArray<uint64_t> row_offsets;   // offset logique global du debut de chaque ligne
+    CellLengths cell_lengths;           // taille rendue de chaque valeur (separateur inclus)
+
+    bool contains(int rg, int64_t row) const {
+        return rg == row_group_id && row >= first_row && row < first_row + num_rows;
+    }
 
-struct ColumnIndex {
-    int column_id;
+    uint64_t rowStart(int64_t row) const { return row_offsets[row - first_row]; }
 
-    uint64_t column_logical_start;
-    uint64_t column_logical_end;
+    uint64_t rowEnd(int64_t row) const {
+        return row + 1 < first_row + num_rows ? row_offsets[row - first_row + 1] - 1 : block_logical_end;
+    }
 
-    std::vector<PageIndex> pages;
+    uint64_t cellLength(int64_t row, uint32_t col) const {
+        return cell_lengths[static_cast<uint64_t>(row - first_row) * num_columns + col];
+    }
+
+    uint64_t memoryUsage() const {
+        return row_offsets.capacity() * sizeof(uint64_t) + cell_lengths.memoryUsage();
+    }
 };
 
+// Les lignes d'un row group sont numerotees parmi les seules lignes retenues par le filtre
 struct RowGroupIndex {
     int row_group_id;
+    int64_t num_rows;                       // nombre de lignes retenues
+    uint32_t num_columns;
+
+    IndexArray<RowRange> selection;         // plages de lignes retenues, vide si toutes le sont
 
     uint64_t rowgroup_logical_start;
     uint64_t rowgroup_logical_end;
 
-    std::vector<ColumnIndex> columns;
+    int64_t block_rows;                     // nombre de lignes par bloc
+    IndexArray<uint64_t> block_offsets;     // offset logique global du debut de chaque bloc
+    std::vector<RowBlockIndex> blocks;      // blocs detailles, vide si l'index est creux
+
+    uint64_t blockEnd(size_t block) const {
+        return block + 1 < block_offsets.size() ? block_offsets[block + 1] - 1 : rowgroup_logical_end;
+    }
+
+    // Ligne du row group parquet de la ligne retenue row
+    int64_t physicalRow(int64_t row) const {
+        if (selection.empty()) return row;
+        auto it = std::upper_bound(selection.begin(), selection.end(), row,
+            [](int64_t r, const RowRange& range) { return r < range.row; });
+        --it;
+        return it->first_row + (row - it->row);
+    }
+
+    // Plages des lignes retenues [first_row, first_row + num_rows), en lignes du row group parquet
+    std::vector<RowRange> selectedRanges(int64_t first_row, int64_t num_rows) const;
+};
+
+// Indices parquet des colonnes projetees, designees par leur chemin ; toutes les colonnes si names est vide.
+// Throws if a column is unknown.
+std::vector<int> ResolveColumns(const parquet::SchemaDescriptor& schema, const std::vector<std::string>& names);
+
+// Cle de partition Hive d'un fichier d'un jeu de donnees (repertoire key=value de son chemin)
+struct PartitionColumn {
+    std::string name;
+    std::string value;      // vide pour une valeur nulle
+};
+
+struct ParquetFileOptions {
+    // Number of threads used to build the logical index (0: one per hardware thread)
+    unsigned index_threads = 0;
+
+    // Sparse index: number of rows between two stored offsets, the rows of a
+    // block being decoded again on access (0: dense index with every row offset)
+    int64_t checkpoint_rows = 0;
+
+    // Lazy index: without checkpoint_rows, only the rendered size of each row group is kept
+    // when the file is opened, its row offsets being decoded on first access
+    bool lazy_index = false;
+
+    // Byte budget of the process-wide cache of the blocks decoded on access by sparse
+    // and lazy indexes (see RowIndexCache)
+    uint64_t row_index_cache_bytes = 256ull << 20;
+
+    // Byte budget of the process-wide cache of rendered row groups (0: no cache),
+    // and whether cached row groups are kept LZ4-compressed
+    uint64_t rowgroup_cache_bytes = 0;
+    bool rowgroup_cache_lz4 = false;
+
+    // Persistent sidecar index, written on first open and memory-mapped on later
+    // opens of the unchanged file; stored next to the file unless index_cache_dir is set.
+    // Off by default: the driver only reads the user's storage unless asked to write there.
+    bool sidecar_index = false;
+    std::string index_cache_dir;
+
+    // Column projection: dot paths of the rendered columns, in stream order (empty: all columns)
+    std::vector<std::string> columns;
+
+    // Row filter expression (see RowFilter), empty to keep every row
+    std::string filter;
+
+    // Read the parquet file through a memory mapping instead of read calls: pages and
+    // footer are then read without copy from the page cache
+    bool memory_map = false;
+
+    // Sequential reads: number of upcoming non-empty row groups whose column chunks are read
+    // in the background while the current one is rendered (0: no prefetch), and byte budget of
+    // the prefetched chunks of a handle. Unused with memory_map, where the kernel reads ahead.
+    int prefetch_row_groups = 1;
+    uint64_t prefetch_bytes = 256ull << 20;
+
+    // Render the header line of column names (only the first file of a dataset has one)
+    bool header = true;
+
+    // Partition columns rendered after the columns of the file, with the same value on every row
+    std::vector<PartitionColumn> partition_columns;
+
+    // Rows between two stored offsets: 0 for a dense index, -1 for one offset per row group (lazy index)
+    int64_t indexCheckpointRows() const {
+        return checkpoint_rows > 0 ? checkpoint_rows : (lazy_index ? -1 : 0);
+    }
+
+    // Options read from the KHIOPS_PARQUET_* environment variables
+    static ParquetFileOptions FromEnvironment();
+};
+
+
+// Etat immuable d'un fichier indexe, partage par tous les handles du fichier (voir IndexRegistry)
+struct ParquetFileIndex {
+    std::shared_ptr<parquet::FileMetaData> metadata;
+
+    std::vector<int> columns;               // indices parquet des colonnes rendues, dans l'ordre du flux
+    RowFilter filter;
+
+    std::vector<std::string> partition_values;  // rendu des colonnes de partition, rendues apres columns
+
+    uint64_t logical_size = 0;
+    std::vector<HeaderIndex> headers;
+    std::vector<RowGroupIndex> row_groups;  // vector containing all metadata logical index
+
+    // Identite du fichier (chemin, taille, date), de la projection et du filtre, cle du cache des row groups
+    std::string file_key;
+
+    // Sidecar projete en memoire, sur lequel pointent les tableaux de row_groups
+    std::shared_ptr<arrow::Buffer> sidecar_buffer;
+
+    uint32_t numColumns() const { return static_cast<uint32_t>(columns.size() + partition_values.size()); }
 };
 
 
@@ -62,40 +264,127 @@ class ParquetFile {
 
     public:
         uint64_t pos = 0;               // logical current position
-        uint64_t logical_size = 0;
 
-        std::vector<HeaderIndex> headers;
-		std::vector<RowGroupIndex> row_groups; // vector containing all metadata logical index
+        std::shared_ptr<const ParquetFileIndex> index;
 
+        // Lecteur propre au handle, ouvert avec les metadonnees partagees
         std::unique_ptr<parquet::arrow::FileReader> reader;
 
         std::shared_ptr<parquet::FileMetaData> metadata;
 
+        ParquetFileOptions options;
+
         
 
     private:
+        // Fichier parquet lu par le handle, son contenu s'il est projete en memoire, et row group
+        // dont la lecture a ete annoncee
+        std::shared_ptr<arrow::io::RandomAccessFile> input;
+        std::shared_ptr<arrow::Buffer> mapped_content;
+        std::shared_ptr<PrefetchingFile> prefetcher;
+        int advised_rg = -1;
+
+        RowIndexCache::Block block_cache;   // dernier bloc lu (index creux ou paresseux)
+
+        // Curseurs de lecture sequentielle des colonnes du row group courant
+        int cursor_rg = -1;
+        std::shared_ptr<parquet::RowGroupReader> cursor_rg_reader;
+        std::vector<std::unique_ptr<ColumnCursor>> cursors;
+
+        // Derniere ligne rendue, et sa ligne dans le row group parquet
+        int last_rg = -1;
+        int64_t last_row = -1;
+        int64_t last_physical_row = -1;
+
+        // Index des offsets des pages des colonnes du row group offset_indexes_rg, par indice parquet
+        int offset_indexes_rg = -1;
+        std::vector<std::shared_ptr<parquet::OffsetIndex>> offset_indexes;
+
+        // Pages sautees des colonnes du row group pages_rg
+        int pages_rg = -1;
+        std::vector<std::shared_ptr<const SkippedPages>> pages;
+
+        // Dernier row group rendu obtenu du cache
+        int rowgroup_text_rg = -1;
+        RowGroupCache::Text rowgroup_text;
+
+        uint64_t BuildHeaderIndex(ParquetFileIndex& file_index) const;
+
+        void BuildLogicalIndex(ParquetFileIndex& file_index) const;
 
-        void BuildLogicalIndex();
+        void BuildRowGroupIndex(uint32_t rg,
+                                const std::vector<int>& columns,
+                                const std::vector<std::string>& partition_values,
+                                const RowFilter& filter,
+                                const std::vector<std::shared_ptr<parquet::OffsetIndex>>& offset_indexes,
+                                RowGroupIndex& rg_idx) const;
+
+        void DecodeRowBlock(std::vector<std::unique_ptr<ColumnLengths>>& col_lengths,
+                            const std::vector<RowRange>& ranges,
+                            int64_t num_rows,
+                            RowBlockIndex& block) const;
+
+        // Lu au premier acces direct a une page du row group, vide si le fichier n'a pas d'index des pages
+        const std::vector<std::shared_ptr<parquet::OffsetIndex>>& offsetIndexes(size_t rg);
+
+        const std::vector<std::shared_ptr<const SkippedPages>>& skippedPages(size_t rg);
+
+        // Acces direct aux pages de la colonne col du row group, avec l'index des offsets si
+        // use_offset_index ou si les lignes du row group sont filtrees
+        PageSeek pageSeek(size_t rg, uint32_t col, bool use_offset_index);
+
+        // Annonce a la projection memoire la lecture prochaine des column chunks du row group,
+        // ou la fin de leur lecture : leurs pages quittent alors la memoire residente du processus
+        void adviseRowGroup(int rg, const std::vector<int>& columns, bool will_need) const;
+
+        // Lit d'avance les column chunks des row groups suivant rg
+        void prefetchRowGroups(int rg, bool sequential);
+
+        // Annonce la lecture du row group rg par le handle, et la fin de celle du precedent
+        void enterRowGroup(int rg);
 
 
     public:
-        ParquetFile(const std::string& path);
+        ParquetFile(const std::string& path, const ParquetFileOptions& options = ParquetFileOptions());
 
         ~ParquetFile();
 
         void dumpInfo();
 
+        const RowBlockIndex& getRowBlock(size_t rg, int64_t row);
+
         bool findValueAtLogicalPosition(size_t& out_row_group,
+            int64_t& out_row,
             size_t& out_column,
-            size_t& out_page,
-            size_t& out_value,
+            uint64_t& out_value_start,
             size_t& out_header);
 
-        bool readHeader(size_t header, std::string& out_bytes);
+        // Debut de ligne proche de target, pour le decoupage du flux en plages de lignes entieres : debut
+        // du row group le plus proche s'il est a moins de tolerance octets, sinon debut de la premiere ligne
+        // commencant a target ou apres. Une cible dans l'en-tete donne la premiere ligne (0 pour 0).
+        uint64_t rowAlignedOffset(uint64_t target, uint64_t tolerance);
+
+        // Offset logique du debut de la ligne row parmi les lignes rendues, logical_size apres la derniere
+        uint64_t rowOffset(int64_t row);
+
+        // Lit d'avance les column chunks des premiers row groups du fichier, avant sa lecture sequentielle
+        void prefetchStart();
+
+        bool useRowGroupCache() const;
+
+        // Texte rendu complet du row group, depuis le cache commun ou rendu puis mis en cache
+        RowGroupCache::Text getRowGroupText(size_t rg);
+
+        // Ecrit l'en-tete suivi de son separateur (taille header_logical_end - header_logical_start + 1)
+        bool renderHeader(size_t header, uint8_t* out) const;
+
+        // Ecrit directement dans out la valeur suivie de son separateur, len etant sa taille dans l'index
+        bool renderValue(size_t rg,
+                         uint32_t col,
+                         int64_t row,
+                         uint64_t len,
+                         uint8_t* out);
 
-        bool readValue(int rg,
-                       int col,
-                       int page,
-                       int value,
-                       std::vector<uint8_t>& out_bytes);
+        // Zone tampon de la valeur a cheval sur la fin du buffer de driver_fread
+        std::vector<uint8_t> scratch;
 };
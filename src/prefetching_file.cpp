@@ -0,0 +1,125 @@
+#include "prefetching_file.h"
+
+#include <cstring>
+
+PrefetchingFile::PrefetchingFile(std::shared_ptr<arrow::io::RandomAccessFile> file, uint64_t budget_bytes)
+    : file(std::move(file)), budget(budget_bytes) {}
+
+PrefetchingFile::~PrefetchingFile() {}
+
+bool PrefetchingFile::prefetch(int rg, const std::vector<arrow::io::ReadRange>& ranges) {
+    uint64_t bytes = 0;
+    for (const arrow::io::ReadRange& range : ranges) {
+        bytes += static_cast<uint64_t>(range.length);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stored + bytes > budget) return false;
+
+    for (const arrow::io::ReadRange& range : ranges) {
+        if (range.length <= 0 || chunks.count(range.offset) > 0) continue;
+        chunks.emplace(range.offset, Chunk{ rg, range.length, file->ReadAsync(arrow::io::default_io_context(), range.offset, range.length) });
+        stored += static_cast<uint64_t>(range.length);
+    }
+    return true;
+}
+
+bool PrefetchingFile::prefetched(int rg) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& entry : chunks) {
+        if (entry.second.rg == rg) return true;
+    }
+    return false;
+}
+
+void PrefetchingFile::retain(int first_rg, int end_rg) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = chunks.begin(); it != chunks.end();) {
+        if (it->second.rg < first_rg || it->second.rg >= end_rg) {
+            // Une lecture en cours se termine dans le pool, son resultat est alors libere
+            stored -= static_cast<uint64_t>(it->second.length);
+            it = chunks.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+uint64_t PrefetchingFile::storedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stored;
+}
+
+std::shared_ptr<arrow::Buffer> PrefetchingFile::find(int64_t position, int64_t nbytes) {
+    arrow::Future<std::shared_ptr<arrow::Buffer>> data;
+    int64_t start;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = chunks.upper_bound(position);
+        if (it == chunks.begin()) return nullptr;
+        --it;
+        if (position + nbytes > it->first + it->second.length) return nullptr;
+        start = it->first;
+        data = it->second.data;
+    }
+
+    // Attente hors du verrou ; en cas d'erreur la lecture est refaite sur le fichier, qui la signale
+    const arrow::Result<std::shared_ptr<arrow::Buffer>>& result = data.result();
+    if (!result.ok() || (*result)->size() < position - start + nbytes) return nullptr;
+    return arrow::SliceBuffer(*result, position - start, nbytes);
+}
+
+arrow::Status PrefetchingFile::Close() {
+    // Les lectures en cours se terminent avant la fermeture du fichier qu'elles lisent
+    std::vector<arrow::Future<std::shared_ptr<arrow::Buffer>>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& entry : chunks) {
+            pending.push_back(std::move(entry.second.data));
+        }
+        chunks.clear();
+        stored = 0;
+    }
+    for (auto& data : pending) {
+        data.Wait();
+    }
+    return file->Close();
+}
+
+bool PrefetchingFile::closed() const {
+    return file->closed();
+}
+
+arrow::Result<int64_t> PrefetchingFile::Tell() const {
+    return file->Tell();
+}
+
+arrow::Status PrefetchingFile::Seek(int64_t position) {
+    return file->Seek(position);
+}
+
+arrow::Result<int64_t> PrefetchingFile::Read(int64_t nbytes, void* out) {
+    return file->Read(nbytes, out);
+}
+
+arrow::Result<std::shared_ptr<arrow::Buffer>> PrefetchingFile::Read(int64_t nbytes) {
+    return file->Read(nbytes);
+}
+
+arrow::Result<int64_t> PrefetchingFile::GetSize() {
+    return file->GetSize();
+}
+
+arrow::Result<int64_t> PrefetchingFile::ReadAt(int64_t position, int64_t nbytes, void* out) {
+    std::shared_ptr<arrow::Buffer> buffer = find(position, nbytes);
+    if (!buffer) return file->ReadAt(position, nbytes, out);
+    std::memcpy(out, buffer->data(), static_cast<size_t>(nbytes));
+    return nbytes;
+}
+
+arrow::Result<std::shared_ptr<arrow::Buffer>> PrefetchingFile::ReadAt(int64_t position, int64_t nbytes) {
+    std::shared_ptr<arrow::Buffer> buffer = find(position, nbytes);
+    if (!buffer) return file->ReadAt(position, nbytes);
+    return buffer;
+}
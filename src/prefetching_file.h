@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+#include <arrow/buffer.h>
+#include <arrow/io/interfaces.h>
+#include <arrow/util/future.h>
+
+// Fichier parquet dont les column chunks des prochains row groups sont lus d'avance.
+// Les plages annoncees par prefetch() sont lues de facon asynchrone par le pool d'entrees-sorties
+// d'Arrow ; une lecture contenue dans l'une d'elles attend la fin de sa lecture puis en renvoie une
+// vue sans copie, les autres lectures sont transmises au fichier sous-jacent.
+// La taille totale des plages conservees est bornee par un budget en octets.
+class PrefetchingFile : public arrow::io::RandomAccessFile {
+
+    public:
+        PrefetchingFile(std::shared_ptr<arrow::io::RandomAccessFile> file, uint64_t budget_bytes);
+
+        ~PrefetchingFile() override;
+
+        // Lance la lecture des plages du row group rg.
+        // Returns false, without reading anything, if they do not fit in the remaining budget.
+        bool prefetch(int rg, const std::vector<arrow::io::ReadRange>& ranges);
+
+        bool prefetched(int rg) const;
+
+        // Abandonne les plages des row groups hors de [first_rg, end_rg)
+        void retain(int first_rg, int end_rg);
+
+        uint64_t storedBytes() const;
+
+        arrow::Status Close() override;
+        bool closed() const override;
+        arrow::Result<int64_t> Tell() const override;
+        arrow::Status Seek(int64_t position) override;
+        arrow::Result<int64_t> Read(int64_t nbytes, void* out) override;
+        arrow::Result<std::shared_ptr<arrow::Buffer>> Read(int64_t nbytes) override;
+        arrow::Result<int64_t> GetSize() override;
+        arrow::Result<int64_t> ReadAt(int64_t position, int64_t nbytes, void* out) override;
+        arrow::Result<std::shared_ptr<arrow::Buffer>> ReadAt(int64_t position, int64_t nbytes) override;
+
+    private:
+        struct Chunk {
+            int rg;
+            int64_t length;
+            arrow::Future<std::shared_ptr<arrow::Buffer>> data;
+        };
+
+        std::shared_ptr<arrow::io::RandomAccessFile> file;
+        uint64_t budget;
+
+        mutable std::mutex mutex;
+        uint64_t stored = 0;
+        std::map<int64_t, Chunk> chunks;   // par offset de debut dans le fichier
+
+        // Returns the buffer of the chunk containing [position, position + nbytes), nullptr if none
+        std::shared_ptr<arrow::Buffer> find(int64_t position, int64_t nbytes);
+};
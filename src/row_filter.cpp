@@ -0,0 +1,703 @@
+#include "row_filter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <parquet/bloom_filter.h>
+#include <parquet/bloom_filter_reader.h>
+#include <parquet/page_index.h>
+#include <parquet/statistics.h>
+
+using parquet::Type;
+
+namespace {
+
+// Plage de lignes [first, second) d'un row group
+using Rows = std::pair<int64_t, int64_t>;
+
+// Resultat d'une comparaison impliquant NaN
+constexpr int kUnordered = 2;
+
+// Nombre de valeurs decodees par appel a ReadBatch lors de l'evaluation du filtre
+constexpr int64_t kFilterBatchSize = 4096;
+
+bool IsNameChar(char c) {
+    return !std::isspace(static_cast<unsigned char>(c)) && std::strchr("=!<>(),'\"", c) == nullptr;
+}
+
+class Lexer {
+
+    public:
+        explicit Lexer(const std::string& text) : text(text) {}
+
+        bool atEnd() {
+            skipSpaces();
+            return pos == text.size();
+        }
+
+        bool accept(const char* symbol) {
+            skipSpaces();
+            const size_t len = std::strlen(symbol);
+            if (text.compare(pos, len, symbol) != 0) return false;
+            pos += len;
+            return true;
+        }
+
+        // Mot cle insensible a la casse, suivi d'un caractere qui ne peut pas prolonger un nom
+        bool acceptKeyword(const char* keyword) {
+            skipSpaces();
+            const size_t len = std::strlen(keyword);
+            if (text.size() - pos < len) return false;
+            for (size_t i = 0; i < len; i++) {
+                if (std::toupper(static_cast<unsigned char>(text[pos + i])) != keyword[i]) return false;
+            }
+            if (pos + len < text.size() && IsNameChar(text[pos + len])) return false;
+            pos += len;
+            return true;
+        }
+
+        void expect(const char* symbol) {
+            if (!accept(symbol)) fail(std::string("'") + symbol + "' expected");
+        }
+
+        std::string name() {
+            skipSpaces();
+            if (pos < text.size() && text[pos] == '"') return quoted('"');
+
+            const size_t start = pos;
+            while (pos < text.size() && IsNameChar(text[pos])) pos++;
+            if (pos == start) fail("column name expected");
+            return text.substr(start, pos - start);
+        }
+
+        FilterValue value() {
+            skipSpaces();
+            FilterValue value;
+            if (pos < text.size() && text[pos] == '\'') {
+                value.text = quoted('\'');
+                return value;
+            }
+
+            const size_t start = pos;
+            while (pos < text.size() && IsNameChar(text[pos])) pos++;
+            value.text = text.substr(start, pos - start);
+
+            const char* first = value.text.data();
+            const char* last = first + value.text.size();
+            auto int_result = std::from_chars(first, last, value.integer);
+            if (int_result.ec == std::errc() && int_result.ptr == last) {
+                value.is_number = true;
+                value.is_integer = true;
+                value.number = static_cast<double>(value.integer);
+                return value;
+            }
+            auto double_result = std::from_chars(first, last, value.number);
+            if (double_result.ec != std::errc() || double_result.ptr != last || value.text.empty()) {
+                fail("invalid value '" + value.text + "'");
+            }
+            value.is_number = true;
+            return value;
+        }
+
+        [[noreturn]] void fail(const std::string& message) const {
+            throw std::runtime_error("Invalid filter at position " + std::to_string(pos) + ": " + message);
+        }
+
+    private:
+        const std::string& text;
+        size_t pos = 0;
+
+        void skipSpaces() {
+            while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) pos++;
+        }
+
+        // Chaine entre delimiteurs, un delimiteur double valant un delimiteur
+        std::string quoted(char quote) {
+            std::string result;
+            pos++;
+            for (;;) {
+                if (pos == text.size()) fail("unterminated string");
+                if (text[pos] == quote) {
+                    if (pos + 1 < text.size() && text[pos + 1] == quote) {
+                        result += quote;
+                        pos += 2;
+                        continue;
+                    }
+                    pos++;
+                    return result;
+                }
+                result += text[pos++];
+            }
+        }
+};
+
+Predicate::Op ParseOp(Lexer& lexer) {
+    if (lexer.accept("==") || lexer.accept("=")) return Predicate::Op::EQ;
+    if (lexer.accept("!=") || lexer.accept("<>")) return Predicate::Op::NE;
+    if (lexer.accept("<=")) return Predicate::Op::LE;
+    if (lexer.accept("<")) return Predicate::Op::LT;
+    if (lexer.accept(">=")) return Predicate::Op::GE;
+    if (lexer.accept(">")) return Predicate::Op::GT;
+    if (lexer.acceptKeyword("IN")) return Predicate::Op::IN;
+    lexer.fail("comparison operator expected");
+}
+
+// Comparaison d'une valeur de la colonne a la valeur du predicat : -1, 0, 1 ou kUnordered
+int CompareNumbers(double v, double x) {
+    if (std::isnan(v) || std::isnan(x)) return kUnordered;
+    return v < x ? -1 : (v > x ? 1 : 0);
+}
+
+int Compare(int64_t v, const FilterValue& value) {
+    if (value.is_integer) return v < value.integer ? -1 : (v > value.integer ? 1 : 0);
+    return CompareNumbers(static_cast<double>(v), value.number);
+}
+
+int Compare(int32_t v, const FilterValue& value) {
+    return Compare(static_cast<int64_t>(v), value);
+}
+
+int Compare(float v, const FilterValue& value) {
+    return CompareNumbers(v, value.number);
+}
+
+int Compare(double v, const FilterValue& value) {
+    return CompareNumbers(v, value.number);
+}
+
+int Compare(const parquet::ByteArray& v, const FilterValue& value) {
+    const size_t len = std::min<size_t>(v.len, value.text.size());
+    const int c = len > 0 ? std::memcmp(v.ptr, value.text.data(), len) : 0;
+    if (c != 0) return c < 0 ? -1 : 1;
+    return v.len < value.text.size() ? -1 : (v.len > value.text.size() ? 1 : 0);
+}
+
+// Vrai si une valeur de bornes [min, max] peut satisfaire le predicat
+template <typename T>
+bool MayMatch(const Predicate& predicate, const T& min, const T& max) {
+    for (const FilterValue& value : predicate.values) {
+        const int lo = Compare(min, value);
+        const int hi = Compare(max, value);
+        if (lo == kUnordered || hi == kUnordered) return true;
+
+        switch (predicate.op)
+        {
+        case Predicate::Op::EQ:
+        case Predicate::Op::IN:
+            if (lo <= 0 && hi >= 0) return true;
+            break;
+        case Predicate::Op::NE:
+            // Les statistiques ignorent NaN, qui est different de toute valeur
+            if (std::is_floating_point_v<T> || lo != 0 || hi != 0) return true;
+            break;
+        case Predicate::Op::LT: if (lo < 0) return true; break;
+        case Predicate::Op::LE: if (lo <= 0) return true; break;
+        case Predicate::Op::GT: if (hi > 0) return true; break;
+        case Predicate::Op::GE: if (hi >= 0) return true; break;
+        }
+    }
+    return false;
+}
+
+// Les bornes ne sont exploitables que si leur ordre est celui des comparaisons du filtre
+bool HasComparableBounds(const parquet::ColumnDescriptor& descr) {
+    const parquet::SortOrder::type order = descr.sort_order();
+    return descr.physical_type() == Type::BYTE_ARRAY ? order == parquet::SortOrder::UNSIGNED
+                                                     : order == parquet::SortOrder::SIGNED;
+}
+
+template <typename DType>
+bool StatisticsMayMatch(const parquet::Statistics& stats, const Predicate& predicate) {
+    auto* typed = dynamic_cast<const parquet::TypedStatistics<DType>*>(&stats);
+    return !typed || MayMatch(predicate, typed->min(), typed->max());
+}
+
+bool ColumnChunkMayMatch(const parquet::RowGroupMetaData& rg_metadata, const Predicate& predicate) {
+    auto chunk = rg_metadata.ColumnChunk(predicate.column);
+    std::shared_ptr<parquet::Statistics> stats = chunk->statistics();
+    if (!stats) return true;
+
+    // Colonne entierement nulle
+    if (stats->HasNullCount() && stats->null_count() >= chunk->num_values()) return false;
+
+    const parquet::ColumnDescriptor* descr = rg_metadata.schema()->Column(predicate.column);
+    if (!stats->HasMinMax() || !HasComparableBounds(*descr)) return true;
+
+    switch (descr->physical_type())
+    {
+    case Type::INT32: return StatisticsMayMatch<parquet::Int32Type>(*stats, predicate);
+    case Type::INT64: return StatisticsMayMatch<parquet::Int64Type>(*stats, predicate);
+    case Type::FLOAT: return StatisticsMayMatch<parquet::FloatType>(*stats, predicate);
+    case Type::DOUBLE: return StatisticsMayMatch<parquet::DoubleType>(*stats, predicate);
+    case Type::BYTE_ARRAY: return StatisticsMayMatch<parquet::ByteArrayType>(*stats, predicate);
+    default:
+        return true;
+    }
+}
+
+// Valeur entiere exacte de la valeur du predicat
+bool IntegerValue(const FilterValue& value, int64_t& out) {
+    if (value.is_integer) {
+        out = value.integer;
+        return true;
+    }
+    if (!value.is_number || std::trunc(value.number) != value.number ||
+        value.number < -9223372036854775808.0 || value.number >= 9223372036854775808.0) {
+        return false;
+    }
+    out = static_cast<int64_t>(value.number);
+    return true;
+}
+
+// Faux si la colonne ne contient certainement pas la valeur, qui est hachee dans son type physique
+bool BloomFilterMayContain(const parquet::BloomFilter& bloom, Type::type type, const FilterValue& value) {
+    switch (type)
+    {
+    case Type::INT32: {
+        int64_t v;
+        if (!IntegerValue(value, v) || v < std::numeric_limits<int32_t>::min() || v > std::numeric_limits<int32_t>::max()) return false;
+        return bloom.FindHash(bloom.Hash(static_cast<int32_t>(v)));
+    }
+    case Type::INT64: {
+        int64_t v;
+        if (!IntegerValue(value, v)) return false;
+        return bloom.FindHash(bloom.Hash(v));
+    }
+    case Type::FLOAT: {
+        // -0.0 et 0.0 sont egaux mais haches differemment
+        const float v = static_cast<float>(value.number);
+        if (static_cast<double>(v) != value.number) return false;
+        return bloom.FindHash(bloom.Hash(v)) || (v == 0 && bloom.FindHash(bloom.Hash(-v)));
+    }
+    case Type::DOUBLE: {
+        const double v = value.number;
+        if (std::isnan(v)) return false;
+        return bloom.FindHash(bloom.Hash(v)) || (v == 0 && bloom.FindHash(bloom.Hash(-v)));
+    }
+    case Type::BYTE_ARRAY: {
+        const parquet::ByteArray v(static_cast<uint32_t>(value.text.size()), reinterpret_cast<const uint8_t*>(value.text.data()));
+        return bloom.FindHash(bloom.Hash(&v));
+    }
+    default:
+        return true;
+    }
+}
+
+bool BloomFilterMayMatch(const parquet::BloomFilter& bloom, Type::type type, const Predicate& predicate) {
+    for (const FilterValue& value : predicate.values) {
+        if (BloomFilterMayContain(bloom, type, value)) return true;
+    }
+    return false;
+}
+
+// Plages des pages du column chunk pouvant contenir une ligne satisfaisant le predicat.
+// Returns false if the page index cannot be used.
+template <typename DType>
+bool PageRangesMayMatch(const parquet::ColumnIndex& column_index,
+                        const parquet::OffsetIndex& offset_index,
+                        int64_t num_rows,
+                        const Predicate& predicate,
+                        std::vector<Rows>& ranges) {
+    auto* typed = dynamic_cast<const parquet::TypedColumnIndex<DType>*>(&column_index);
+    if (!typed) return false;
+
+    const std::vector<parquet::PageLocation>& locations = offset_index.page_locations();
+    const std::vector<bool>& null_pages = column_index.null_pages();
+    if (null_pages.size() != locations.size()) return false;
+
+    // Les bornes sont donnees pour chaque page, ou pour les seules pages non nulles
+    const auto& min_values = typed->min_values();
+    const auto& max_values = typed->max_values();
+    const bool compact = min_values.size() != locations.size();
+    if (compact && min_values.size() != column_index.non_null_page_indices().size()) return false;
+    if (max_values.size() != min_values.size()) return false;
+
+    size_t bounds = 0;
+    for (size_t page = 0; page < locations.size(); page++) {
+        bool may_match = false;
+        if (!null_pages[page]) {
+            const size_t i = compact ? bounds++ : page;
+            may_match = MayMatch(predicate, min_values[i], max_values[i]);
+        }
+        if (!may_match) continue;
+
+        const int64_t first = locations[page].first_row_index;
+        const int64_t end = page + 1 < locations.size() ? locations[page + 1].first_row_index : num_rows;
+        if (!ranges.empty() && ranges.back().second == first) {
+            ranges.back().second = end;
+        }
+        else {
+            ranges.emplace_back(first, end);
+        }
+    }
+    return true;
+}
+
+bool PageRangesMayMatch(const parquet::ColumnDescriptor& descr,
+                        const parquet::ColumnIndex& column_index,
+                        const parquet::OffsetIndex& offset_index,
+                        int64_t num_rows,
+                        const Predicate& predicate,
+                        std::vector<Rows>& ranges) {
+    if (!HasComparableBounds(descr)) return false;
+
+    switch (descr.physical_type())
+    {
+    case Type::INT32: return PageRangesMayMatch<parquet::Int32Type>(column_index, offset_index, num_rows, predicate, ranges);
+    case Type::INT64: return PageRangesMayMatch<parquet::Int64Type>(column_index, offset_index, num_rows, predicate, ranges);
+    case Type::FLOAT: return PageRangesMayMatch<parquet::FloatType>(column_index, offset_index, num_rows, predicate, ranges);
+    case Type::DOUBLE: return PageRangesMayMatch<parquet::DoubleType>(column_index, offset_index, num_rows, predicate, ranges);
+    case Type::BYTE_ARRAY: return PageRangesMayMatch<parquet::ByteArrayType>(column_index, offset_index, num_rows, predicate, ranges);
+    default:
+        return false;
+    }
+}
+
+bool Satisfies(Predicate::Op op, int cmp) {
+    if (cmp == kUnordered) return op == Predicate::Op::NE;
+    switch (op)
+    {
+    case Predicate::Op::EQ:
+    case Predicate::Op::IN: return cmp == 0;
+    case Predicate::Op::NE: return cmp != 0;
+    case Predicate::Op::LT: return cmp < 0;
+    case Predicate::Op::LE: return cmp <= 0;
+    case Predicate::Op::GT: return cmp > 0;
+    case Predicate::Op::GE: return cmp >= 0;
+    }
+    return false;
+}
+
+// out[i] |= (values[i] op x). L'operateur est choisi hors de la boucle : chaque boucle, sans branche
+// sur des valeurs contigues, est vectorisee par le compilateur. Les comparaisons IEEE donnent a NaN
+// la semantique du filtre : seul != est satisfait.
+template <typename T, typename U>
+void CompareValues(const T* values, int64_t n, Predicate::Op op, U x, uint8_t* out) {
+    switch (op)
+    {
+    case Predicate::Op::EQ:
+    case Predicate::Op::IN:
+        for (int64_t i = 0; i < n; i++) out[i] |= static_cast<uint8_t>(static_cast<U>(values[i]) == x);
+        break;
+    case Predicate::Op::NE:
+        for (int64_t i = 0; i < n; i++) out[i] |= static_cast<uint8_t>(!(static_cast<U>(values[i]) == x));
+        break;
+    case Predicate::Op::LT:
+        for (int64_t i = 0; i < n; i++) out[i] |= static_cast<uint8_t>(static_cast<U>(values[i]) < x);
+        break;
+    case Predicate::Op::LE:
+        for (int64_t i = 0; i < n; i++) out[i] |= static_cast<uint8_t>(static_cast<U>(values[i]) <= x);
+        break;
+    case Predicate::Op::GT:
+        for (int64_t i = 0; i < n; i++) out[i] |= static_cast<uint8_t>(static_cast<U>(values[i]) > x);
+        break;
+    case Predicate::Op::GE:
+        for (int64_t i = 0; i < n; i++) out[i] |= static_cast<uint8_t>(static_cast<U>(values[i]) >= x);
+        break;
+    }
+}
+
+template <typename T>
+void CompareValues(const T* values, int64_t n, Predicate::Op op, const FilterValue& value, uint8_t* out) {
+    if constexpr (std::is_integral_v<T>) {
+        if (value.is_integer) {
+            CompareValues<T, int64_t>(values, n, op, value.integer, out);
+            return;
+        }
+    }
+    CompareValues<T, double>(values, n, op, value.number, out);
+}
+
+void CompareValues(const parquet::ByteArray* values, int64_t n, Predicate::Op op, const FilterValue& value, uint8_t* out) {
+    for (int64_t i = 0; i < n; i++) {
+        out[i] |= static_cast<uint8_t>(Satisfies(op, Compare(values[i], value)));
+    }
+}
+
+// out[i] = 1 si values[i] satisfait le predicat, 0 sinon
+template <typename T>
+void MatchValues(const Predicate& predicate, const T* values, int64_t n, uint8_t* out) {
+    std::fill(out, out + n, 0);
+    for (const FilterValue& value : predicate.values) {
+        CompareValues(values, n, predicate.op, value, out);
+    }
+}
+
+// Evalue le predicat sur les lignes des plages, lues par col_reader : selected[i] est mis a 0 pour
+// chaque ligne (dans l'ordre des plages) qui ne le satisfait pas. Le predicat est evalue sur tout
+// le batch decode ; une colonne encodee par dictionnaire est evaluee une fois par entree du dictionnaire.
+template <typename DType>
+void EvaluatePredicate(parquet::ColumnReader& col_reader,
+                       const SkippedPages* pages,
+                       const Predicate& predicate,
+                       const std::vector<RowRange>& ranges,
+                       uint8_t* selected) {
+    using T = typename DType::c_type;
+    auto* typed = dynamic_cast<parquet::TypedColumnReader<DType>*>(&col_reader);
+    if (!typed) throw std::runtime_error("Couldn't open typed column reader");
+
+    const int16_t max_def_level = typed->descr()->max_definition_level();
+    const bool use_dictionary = col_reader.GetExposedEncoding() == parquet::ExposedEncoding::DICTIONARY;
+
+    std::vector<int16_t> def_levels(kFilterBatchSize);
+    std::vector<T> values(use_dictionary ? 0 : kFilterBatchSize);
+    std::vector<int32_t> indices(use_dictionary ? kFilterBatchSize : 0);
+    std::vector<uint8_t> matches(kFilterBatchSize);
+
+    const T* matched_dict = nullptr;
+    int32_t matched_dict_len = 0;
+    std::vector<uint8_t> dict_matches;
+
+    std::vector<uint8_t> row_matches(kFilterBatchSize);
+
+    StreamRanges rows(ranges.data(), ranges.size(), pages);
+    int64_t next_row = 0;   // ligne de la prochaine valeur a decoder, sans les pages sautees
+    while (!rows.done()) {
+        // Un long intervalle entre deux plages est saute ; un court est decode avec le batch
+        const int64_t first_row = rows.first();
+        if (first_row - next_row >= kFilterBatchSize) {
+            next_row += typed->Skip(first_row - next_row);
+        }
+
+        const int64_t batch = std::min(kFilterBatchSize, rows.end() - next_row);
+        int64_t values_read = 0;
+        int64_t levels_read;
+        if (use_dictionary) {
+            const T* dict = nullptr;
+            int32_t dict_len = 0;
+            levels_read = typed->ReadBatchWithDictionary(batch, def_levels.data(), nullptr, indices.data(),
+                                                         &values_read, &dict, &dict_len);
+            if (levels_read <= 0) break;
+            if (dict != matched_dict || dict_len != matched_dict_len) {
+                dict_matches.resize(dict_len);
+                MatchValues(predicate, dict, dict_len, dict_matches.data());
+                matched_dict = dict;
+                matched_dict_len = dict_len;
+            }
+            for (int64_t v = 0; v < values_read; v++) {
+                if (indices[v] < 0 || indices[v] >= dict_len) throw std::runtime_error("Invalid dictionary index");
+                matches[v] = dict_matches[indices[v]];
+            }
+        }
+        else {
+            levels_read = typed->ReadBatch(batch, def_levels.data(), nullptr, values.data(), &values_read);
+            if (levels_read <= 0) break;
+            MatchValues(predicate, values.data(), values_read, matches.data());
+        }
+
+        // une valeur nulle ne satisfait aucun predicat
+        const uint8_t* batch_matches = matches.data();
+        if (values_read != levels_read) {
+            int64_t v = 0;
+            for (int64_t i = 0; i < levels_read; i++) {
+                row_matches[i] = def_levels[i] == max_def_level ? matches[v++] : 0;
+            }
+            batch_matches = row_matches.data();
+        }
+
+        rows.take(next_row, next_row + levels_read, [&](int64_t offset, int64_t count) {
+            for (int64_t i = 0; i < count; i++) {
+                selected[i] &= batch_matches[offset + i];
+            }
+            selected += count;
+        });
+        next_row += levels_read;
+    }
+
+    // truncated column chunk: missing values are null
+    std::fill(selected, selected + rows.remaining(), 0);
+}
+
+// Plages des lignes selectionnees des plages
+std::vector<RowRange> SelectedRanges(const std::vector<RowRange>& ranges, const uint8_t* selected) {
+    std::vector<RowRange> result;
+    int64_t row = 0;
+    for (const RowRange& range : ranges) {
+        for (int64_t i = 0; i < range.num_rows; i++) {
+            if (!selected[i]) continue;
+            const int64_t physical_row = range.first_row + i;
+            if (!result.empty() && result.back().first_row + result.back().num_rows == physical_row) {
+                result.back().num_rows++;
+            }
+            else {
+                result.push_back(RowRange{ physical_row, 1, row });
+            }
+            row++;
+        }
+        selected += range.num_rows;
+    }
+    return result;
+}
+
+std::vector<Rows> Intersect(const std::vector<Rows>& a, const std::vector<Rows>& b) {
+    std::vector<Rows> result;
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        const int64_t first = std::max(a[i].first, b[j].first);
+        const int64_t end = std::min(a[i].second, b[j].second);
+        if (first < end) result.emplace_back(first, end);
+        if (a[i].second < b[j].second) i++; else j++;
+    }
+    return result;
+}
+
+} // namespace
+
+RowFilter RowFilter::Parse(const std::string& expression, const parquet::SchemaDescriptor& schema) {
+    RowFilter filter;
+    Lexer lexer(expression);
+    if (lexer.atEnd()) return filter;
+
+    do {
+        const std::string name = lexer.name();
+        const int column = schema.ColumnIndex(name);
+        if (column < 0) throw std::runtime_error("Unknown column: " + name);
+
+        const parquet::ColumnDescriptor* descr = schema.Column(column);
+        if (descr->max_repetition_level() > 0) throw std::runtime_error("Cannot filter on repeated column: " + name);
+
+        Predicate predicate;
+        predicate.column = column;
+        predicate.op = ParseOp(lexer);
+        if (predicate.op == Predicate::Op::IN) {
+            lexer.expect("(");
+            do {
+                predicate.values.push_back(lexer.value());
+            } while (lexer.accept(","));
+            lexer.expect(")");
+        }
+        else {
+            predicate.values.push_back(lexer.value());
+        }
+
+        switch (descr->physical_type())
+        {
+        case Type::INT32:
+        case Type::INT64:
+        case Type::FLOAT:
+        case Type::DOUBLE:
+            for (const FilterValue& value : predicate.values) {
+                if (!value.is_number) throw std::runtime_error("Numeric value expected for column: " + name);
+            }
+            break;
+        case Type::BYTE_ARRAY:
+            break;
+        default:
+            throw std::runtime_error("Unsupported filter column type: " + name);
+        }
+
+        filter.predicates.push_back(std::move(predicate));
+    } while (lexer.acceptKeyword("AND"));
+
+    if (!lexer.atEnd()) lexer.fail("'AND' expected");
+    return filter;
+}
+
+std::vector<RowRange> RowFilter::SelectRows(parquet::ParquetFileReader& file_reader, int rg) const {
+    auto rg_metadata = file_reader.metadata()->RowGroup(rg);
+    const int64_t num_rows = rg_metadata->num_rows();
+    if (num_rows == 0) return {};
+    if (empty()) return { RowRange{ 0, num_rows, 0 } };
+
+    // Statistiques du footer
+    for (const Predicate& predicate : predicates) {
+        if (!ColumnChunkMayMatch(*rg_metadata, predicate)) return {};
+    }
+
+    // Filtres de Bloom des predicats d'egalite ; un filtre illisible est ignore
+    try {
+        auto rg_bloom = file_reader.GetBloomFilterReader().RowGroup(rg);
+        for (const Predicate& predicate : predicates) {
+            if (!rg_bloom || (predicate.op != Predicate::Op::EQ && predicate.op != Predicate::Op::IN)) continue;
+            std::unique_ptr<parquet::BloomFilter> bloom = rg_bloom->GetColumnBloomFilter(predicate.column);
+            if (bloom && !BloomFilterMayMatch(*bloom, rg_metadata->schema()->Column(predicate.column)->physical_type(), predicate)) {
+                return {};
+            }
+        }
+    }
+    catch (const std::exception&) {
+    }
+
+    // Index des pages : intersection des pages retenues par chaque predicat
+    std::vector<Rows> selected = { Rows(0, num_rows) };
+    try {
+        auto page_index = file_reader.GetPageIndexReader();
+        auto rg_page_index = page_index ? page_index->RowGroup(rg) : nullptr;
+        for (const Predicate& predicate : predicates) {
+            if (!rg_page_index) break;
+            auto column_index = rg_page_index->GetColumnIndex(predicate.column);
+            auto offset_index = rg_page_index->GetOffsetIndex(predicate.column);
+            if (!column_index || !offset_index) continue;
+
+            std::vector<Rows> pages;
+            if (PageRangesMayMatch(*rg_metadata->schema()->Column(predicate.column), *column_index, *offset_index,
+                                   num_rows, predicate, pages)) {
+                selected = Intersect(selected, pages);
+            }
+        }
+    }
+    catch (const std::exception&) {
+    }
+
+    std::vector<RowRange> ranges;
+    ranges.reserve(selected.size());
+    int64_t row = 0;
+    for (const Rows& rows : selected) {
+        ranges.push_back(RowRange{ rows.first, rows.second - rows.first, row });
+        row += rows.second - rows.first;
+    }
+    return ranges;
+}
+
+std::vector<RowRange> RowFilter::EvaluateRows(parquet::RowGroupReader& rg_reader, std::vector<RowRange> ranges, const std::vector<std::shared_ptr<parquet::OffsetIndex>>& offset_indexes) const {
+    const int64_t num_rows = rg_reader.metadata()->num_rows();
+
+    std::vector<uint8_t> selected;
+    for (const Predicate& predicate : predicates) {
+        if (ranges.empty()) break;
+
+        int64_t selected_rows = 0;
+        for (const RowRange& range : ranges) {
+            selected_rows += range.num_rows;
+        }
+        selected.assign(selected_rows, 1);
+
+        // Les pages sans ligne encore retenue ne sont pas decodees
+        std::shared_ptr<const SkippedPages> pages;
+        if (static_cast<size_t>(predicate.column) < offset_indexes.size() && offset_indexes[predicate.column]) {
+            pages = SkippedPages::Make(*offset_indexes[predicate.column], num_rows, ranges.data(), ranges.size());
+        }
+        std::shared_ptr<parquet::ColumnReader> col_reader = OpenColumnReader(rg_reader, predicate.column, pages);
+
+        switch (col_reader->descr()->physical_type())
+        {
+        case Type::INT32:
+            EvaluatePredicate<parquet::Int32Type>(*col_reader, pages.get(), predicate, ranges, selected.data());
+            break;
+        case Type::INT64:
+            EvaluatePredicate<parquet::Int64Type>(*col_reader, pages.get(), predicate, ranges, selected.data());
+            break;
+        case Type::FLOAT:
+            EvaluatePredicate<parquet::FloatType>(*col_reader, pages.get(), predicate, ranges, selected.data());
+            break;
+        case Type::DOUBLE:
+            EvaluatePredicate<parquet::DoubleType>(*col_reader, pages.get(), predicate, ranges, selected.data());
+            break;
+        case Type::BYTE_ARRAY:
+            EvaluatePredicate<parquet::ByteArrayType>(*col_reader, pages.get(), predicate, ranges, selected.data());
+            break;
+        default:
+            throw std::runtime_error("Unsupported type");
+        }
+
+        ranges = SelectedRanges(ranges, selected.data());
+    }
+    return ranges;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <parquet/api/reader.h>
+
+#include "column_cursor.h"
+
+// Filtre des lignes du flux : conjonction de predicats sur des colonnes non repetees.
+//   expression := predicat [AND predicat]...
+//   predicat   := colonne op valeur | colonne IN (valeur, ...)
+//   op         := = | == | != | <> | < | <= | > | >=
+// Une colonne est designee par son chemin, entre guillemets doubles si necessaire ; une valeur est
+// un nombre ou une chaine entre apostrophes (apostrophes internes doublees). Les colonnes de type
+// BYTE_ARRAY sont comparees octet par octet, les colonnes numeriques par valeur.
+// Une valeur nulle ne satisfait aucun predicat.
+//
+// Les row groups puis les pages qui ne peuvent contenir aucune ligne satisfaisant le filtre sont
+// ecartes d'apres les statistiques du footer, les filtres de Bloom et l'index des pages. Les predicats
+// sont ensuite evalues ligne a ligne sur les pages restantes.
+
+// Valeur litterale d'un predicat
+struct FilterValue {
+    std::string text;           // texte de la valeur, compare aux valeurs BYTE_ARRAY
+    bool is_number = false;
+    bool is_integer = false;    // valeur entiere exacte sur 64 bits
+    int64_t integer = 0;
+    double number = 0;
+};
+
+struct Predicate {
+    enum class Op { EQ, NE, LT, LE, GT, GE, IN };
+
+    int column;                         // indice parquet de la colonne
+    Op op;
+    std::vector<FilterValue> values;    // une seule valeur, sauf pour IN
+};
+
+class RowFilter {
+
+    public:
+        // Throws if the expression is invalid or names an unknown or repeated column
+        static RowFilter Parse(const std::string& expression, const parquet::SchemaDescriptor& schema);
+
+        bool empty() const { return predicates.empty(); }
+
+        // Plages de lignes du row group pouvant satisfaire le filtre (toutes si le filtre est vide).
+        // Utilise l'index des pages et les filtres de Bloom du lecteur, qui ne doit pas etre
+        // utilise simultanement par un autre thread.
+        std::vector<RowRange> SelectRows(parquet::ParquetFileReader& file_reader, int rg) const;
+
+        // Lignes des plages satisfaisant le filtre, les colonnes des predicats etant decodees l'une
+        // apres l'autre sur les seules lignes retenues par les predicats precedents.
+        // offset_indexes donne l'index des offsets des pages de chaque colonne parquet, s'il est connu.
+        std::vector<RowRange> EvaluateRows(parquet::RowGroupReader& rg_reader,
+                                           std::vector<RowRange> ranges,
+                                           const std::vector<std::shared_ptr<parquet::OffsetIndex>>& offset_indexes) const;
+
+        std::vector<Predicate> predicates;
+};
@@ -0,0 +1,57 @@
+#include "row_index_cache.h"
+
+RowIndexCache& RowIndexCache::instance() {
+    static RowIndexCache cache;
+    return cache;
+}
+
+void RowIndexCache::configure(uint64_t budget_bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->budget = budget_bytes;
+    evict();
+}
+
+std::string RowIndexCache::makeKey(const std::string& file_key, int rg, int64_t first_row, int64_t num_rows) {
+    return file_key + '#' + std::to_string(rg) + '#' + std::to_string(first_row) + '+' + std::to_string(num_rows);
+}
+
+RowIndexCache::Block RowIndexCache::get(const std::string& file_key, int rg, int64_t first_row, int64_t num_rows) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(makeKey(file_key, rg, first_row, num_rows));
+    if (it == entries.end()) return nullptr;
+
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->block;
+}
+
+void RowIndexCache::put(const std::string& file_key, int rg, int64_t first_row, int64_t num_rows, Block block, uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (bytes > budget) return;
+
+    const std::string key = makeKey(file_key, rg, first_row, num_rows);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        stored -= it->second->bytes;
+        lru.erase(it->second);
+        entries.erase(it);
+    }
+
+    stored += bytes;
+    lru.push_front(Entry{ key, std::move(block), bytes });
+    entries[key] = lru.begin();
+    evict();
+}
+
+uint64_t RowIndexCache::storedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stored;
+}
+
+void RowIndexCache::evict() {
+    while (stored > budget && !lru.empty()) {
+        const Entry& last = lru.back();
+        stored -= last.bytes;
+        entries.erase(last.key);
+        lru.pop_back();
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+struct RowBlockIndex;
+
+// Cache commun au processus des blocs detailles de l'index (offsets des lignes et tailles des valeurs).
+// Un index creux ou paresseux ne conserve que l'offset de chaque bloc ; le detail d'un bloc est decode
+// a sa premiere lecture puis partage par tous les handles du fichier. Les blocs sont evinces selon
+// l'ordre LRU des que leur taille totale depasse le budget, et restent valides pour les handles qui
+// les lisent encore.
+class RowIndexCache {
+
+    public:
+        using Block = std::shared_ptr<const RowBlockIndex>;
+
+        static RowIndexCache& instance();
+
+        // Budget en octets (0 : cache desactive)
+        void configure(uint64_t budget_bytes);
+
+        // Returns the block of the num_rows rows of the row group starting at first_row, nullptr if not cached
+        Block get(const std::string& file_key, int rg, int64_t first_row, int64_t num_rows);
+
+        void put(const std::string& file_key, int rg, int64_t first_row, int64_t num_rows, Block block, uint64_t bytes);
+
+        uint64_t storedBytes() const;
+
+    private:
+        struct Entry {
+            std::string key;
+            Block block;
+            uint64_t bytes;
+        };
+
+        mutable std::mutex mutex;
+        uint64_t budget = 0;
+        uint64_t stored = 0;
+
+        std::list<Entry> lru;   // le plus recemment utilise en tete
+        std::unordered_map<std::string, std::list<Entry>::iterator> entries;
+
+        static std::string makeKey(const std::string& file_key, int rg, int64_t first_row, int64_t num_rows);
+
+        void evict();
+};
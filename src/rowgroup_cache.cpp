@@ -0,0 +1,113 @@
+#include "rowgroup_cache.h"
+
+#include <arrow/util/compression.h>
+
+RowGroupCache& RowGroupCache::instance() {
+    static RowGroupCache cache;
+    return cache;
+}
+
+void RowGroupCache::configure(uint64_t budget_bytes, bool compress) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->budget = budget_bytes;
+    this->compress = compress && arrow::util::Codec::IsAvailable(arrow::Compression::LZ4_FRAME);
+    evict();
+}
+
+bool RowGroupCache::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budget > 0;
+}
+
+std::string RowGroupCache::makeKey(const std::string& file_key, int rg) {
+    return file_key + '#' + std::to_string(rg);
+}
+
+RowGroupCache::Text RowGroupCache::get(const std::string& file_key, int rg) {
+    std::shared_ptr<const std::vector<uint8_t>> data;
+    uint64_t raw_size;
+    bool compressed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(makeKey(file_key, rg));
+        if (it == entries.end()) return nullptr;
+
+        lru.splice(lru.begin(), lru, it->second);
+        data = it->second->data;
+        raw_size = it->second->raw_size;
+        compressed = it->second->compressed;
+    }
+
+    if (!compressed) return data;
+
+    // Decompression hors du verrou
+    auto codec = arrow::util::Codec::Create(arrow::Compression::LZ4_FRAME);
+    if (!codec.ok()) return nullptr;
+
+    auto text = std::make_shared<std::vector<uint8_t>>(raw_size);
+    auto result = (*codec)->Decompress(static_cast<int64_t>(data->size()), data->data(),
+                                       static_cast<int64_t>(raw_size), text->data());
+    if (!result.ok() || static_cast<uint64_t>(*result) != raw_size) return nullptr;
+    return text;
+}
+
+void RowGroupCache::put(const std::string& file_key, int rg, Text text) {
+    bool compress_entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (budget == 0) return;
+        compress_entry = compress;
+    }
+
+    Entry entry;
+    entry.file_key = file_key;
+    entry.rg = rg;
+    entry.raw_size = text->size();
+    entry.compressed = false;
+    entry.data = text;
+
+    if (compress_entry) {
+        auto codec = arrow::util::Codec::Create(arrow::Compression::LZ4_FRAME);
+        if (codec.ok()) {
+            const int64_t raw_len = static_cast<int64_t>(text->size());
+            std::vector<uint8_t> packed((*codec)->MaxCompressedLen(raw_len, text->data()));
+            auto result = (*codec)->Compress(raw_len, text->data(), static_cast<int64_t>(packed.size()), packed.data());
+            if (result.ok()) {
+                packed.resize(*result);
+                packed.shrink_to_fit();
+                entry.data = std::make_shared<const std::vector<uint8_t>>(std::move(packed));
+                entry.compressed = true;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entry.data->size() > budget) return;
+
+    const std::string key = makeKey(file_key, rg);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        stored -= it->second->data->size();
+        lru.erase(it->second);
+        entries.erase(it);
+    }
+
+    stored += entry.data->size();
+    lru.push_front(std::move(entry));
+    entries[key] = lru.begin();
+    evict();
+}
+
+uint64_t RowGroupCache::storedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stored;
+}
+
+void RowGroupCache::evict() {
+    while (stored > budget && !lru.empty()) {
+        const Entry& last = lru.back();
+        stored -= last.data->size();
+        entries.erase(makeKey(last.file_key, last.rg));
+        lru.pop_back();
+    }
+}
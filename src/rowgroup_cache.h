@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+// Cache commun au processus du texte rendu des row groups.
+// Les entrees sont identifiees par (identite du fichier, row group) et evincees selon
+// l'ordre LRU des que la taille totale stockee depasse le budget.
+// Le texte peut etre conserve compresse en LZ4 pour faire tenir plus de row groups en memoire.
+class RowGroupCache {
+
+    public:
+        using Text = std::shared_ptr<const std::vector<uint8_t>>;
+
+        static RowGroupCache& instance();
+
+        // Budget en octets (0 : cache desactive)
+        void configure(uint64_t budget_bytes, bool compress);
+
+        bool enabled() const;
+
+        // Returns the rendered text of the row group, nullptr if not cached
+        Text get(const std::string& file_key, int rg);
+
+        void put(const std::string& file_key, int rg, Text text);
+
+        uint64_t storedBytes() const;
+
+    private:
+        struct Entry {
+            std::string file_key;
+            int rg;
+            std::shared_ptr<const std::vector<uint8_t>> data;   // texte, eventuellement compresse
+            uint64_t raw_size;
+            bool compressed;
+        };
+
+        mutable std::mutex mutex;
+        uint64_t budget = 0;
+        bool compress = false;
+        uint64_t stored = 0;
+
+        std::list<Entry> lru;   // le plus recemment utilise en tete
+        std::unordered_map<std::string, std::list<Entry>::iterator> entries;
+
+        static std::string makeKey(const std::string& file_key, int rg);
+
+        void evict();
+};
@@ -0,0 +1,401 @@
+#include "sidecar_index.h"
+#include "value_format.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#include <arrow/io/file.h>
+
+namespace {
+
+// A incrementer a chaque changement du format du sidecar ou du rendu des valeurs
+constexpr uint32_t kSidecarVersion = 4;
+constexpr char kSidecarMagic[8] = { 'K', 'H', 'P', 'Q', 'I', 'D', 'X', '\0' };
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+// Tous les enregistrements et tableaux du sidecar sont alignes sur 8 octets
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+    int64_t mtime;
+    uint64_t footer_hash;
+    int64_t checkpoint_rows;
+    uint32_t num_columns;
+    uint32_t num_row_groups;
+    uint64_t columns_hash;
+    uint64_t view_hash;
+    uint64_t logical_size;
+    uint32_t sep;
+    uint32_t reserved;
+};
+
+// Suivi de selection[num_ranges], de block_offsets[num_blocks] puis des num_resident_blocks blocs
+struct RowGroupRecord {
+    int64_t num_rows;
+    int64_t block_rows;
+    uint64_t logical_start;
+    uint64_t logical_end;
+    uint64_t num_ranges;
+    uint64_t num_blocks;
+    uint64_t num_resident_blocks;
+};
+
+// Suivi de row_offsets[num_rows], des tailles sur 16 bits (completees a 8 octets)
+// puis des num_long_lengths tailles longues
+struct BlockRecord {
+    int64_t first_row;
+    int64_t num_rows;
+    uint64_t block_logical_end;
+    uint64_t num_long_lengths;
+};
+
+uint64_t Fnv1a(const uint8_t* data, size_t len, uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+size_t Padding(size_t len) {
+    return (8 - len % 8) % 8;
+}
+
+class SidecarWriter {
+
+    public:
+        explicit SidecarWriter(const std::string& path) : out(path, std::ios::binary | std::ios::trunc) {}
+
+        bool ok() const { return static_cast<bool>(out); }
+
+        template <typename T>
+        void write(const T& record) { writeBytes(&record, sizeof(T)); }
+
+        template <typename T>
+        void writeArray(const IndexArray<T>& array) {
+            const size_t len = array.size() * sizeof(T);
+            writeBytes(array.data(), len);
+            static const char zeros[8] = {};
+            writeBytes(zeros, Padding(len));
+        }
+
+        void close() { out.close(); }
+
+    private:
+        std::ofstream out;
+
+        void writeBytes(const void* data, size_t len) {
+            if (len > 0) out.write(static_cast<const char*>(data), static_cast<std::streamsize>(len));
+        }
+};
+
+// Lecture bornee du contenu projete : un depassement invalide le sidecar (le contenu est verifie par ReadRowGroup)
+class SidecarReader {
+
+    public:
+        SidecarReader(const uint8_t* data, uint64_t size) : data(data), size(size) {}
+
+        template <typename T>
+        bool read(T& record) {
+            if (size - pos < sizeof(T)) return false;
+            std::memcpy(&record, data + pos, sizeof(T));
+            pos += sizeof(T);
+            return true;
+        }
+
+        template <typename T>
+        bool readArray(IndexArray<T>& array, uint64_t count) {
+            if (count > (size - pos) / sizeof(T)) return false;
+            const uint64_t len = count * sizeof(T);
+            if (size - pos - len < Padding(len)) return false;
+            array.assignView(reinterpret_cast<const T*>(data + pos), count);
+            pos += len + Padding(len);
+            return true;
+        }
+
+        bool atEnd() const { return pos == size; }
+
+    private:
+        const uint8_t* data;
+        uint64_t size;
+        uint64_t pos = 0;
+};
+
+// Offsets de lignes strictement croissants dans le bloc, et longueurs des cellules (au moins le separateur)
+// dont la somme redonne les offsets ; chaque longueur escape doit avoir son entree dans la table
+bool CheckBlock(const RowBlockIndex& block, uint64_t block_start) {
+    const IndexArray<uint16_t>& lengths = block.cell_lengths.lengths;
+    const IndexArray<CellLengths::LongLength>& long_lengths = block.cell_lengths.long_lengths;
+
+    uint64_t num_escaped = 0;
+    for (uint16_t len : lengths) {
+        if (len == 0) return false;
+        num_escaped += len == CellLengths::kLongLength;
+    }
+    if (num_escaped != long_lengths.size()) return false;
+    for (size_t i = 0; i < long_lengths.size(); i++) {
+        const CellLengths::LongLength& long_length = long_lengths[i];
+        if (long_length.cell >= lengths.size() || lengths[long_length.cell] != CellLengths::kLongLength) return false;
+        if (long_length.length < CellLengths::kLongLength) return false;
+        if (i > 0 && long_length.cell <= long_lengths[i - 1].cell) return false;
+    }
+
+    uint64_t offset = block_start;
+    for (int64_t row = block.first_row; row < block.first_row + block.num_rows; row++) {
+        if (block.rowStart(row) != offset) return false;
+        for (uint32_t col = 0; col < block.num_columns; col++) {
+            const uint64_t len = block.cellLength(row, col);
+            if (offset > block.block_logical_end || len > block.block_logical_end - offset + 1) return false;
+            offset += len;
+        }
+    }
+    return block.num_rows == 0 || offset - 1 == block.block_logical_end;
+}
+
+// Lit le row group rg, qui doit commencer a logical_start : les offsets des blocs, des lignes et les
+// longueurs des cellules doivent etre coherents, un sidecar corrompu ne devant pas egarer la lecture
+bool ReadRowGroup(SidecarReader& in, int rg, uint32_t num_columns, uint64_t logical_start, RowGroupIndex& rg_idx) {
+    RowGroupRecord record;
+    if (!in.read(record)) return false;
+    if (record.block_rows <= 0 || record.num_rows < 0) return false;
+
+    // Fin du row group : logical_start - 1 pour un row group vide
+    if (record.logical_start != logical_start) return false;
+    const uint64_t logical_next = record.logical_end + 1;
+    if (logical_next < logical_start || (record.num_rows == 0) != (logical_next == logical_start)) return false;
+
+    rg_idx.row_group_id = rg;
+    rg_idx.num_rows = record.num_rows;
+    rg_idx.num_columns = num_columns;
+    rg_idx.rowgroup_logical_start = record.logical_start;
+    rg_idx.rowgroup_logical_end = record.logical_end;
+    rg_idx.block_rows = record.block_rows;
+
+    // Plages de lignes retenues, contigues dans la numerotation des lignes retenues
+    if (!in.readArray(rg_idx.selection, record.num_ranges)) return false;
+    int64_t selected_rows = 0;
+    for (const RowRange& range : rg_idx.selection) {
+        if (range.row != selected_rows || range.first_row < 0 || range.num_rows < 0) return false;
+        selected_rows += range.num_rows;
+    }
+    if (record.num_ranges != 0 && selected_rows != record.num_rows) return false;
+
+    const uint64_t expected_blocks = static_cast<uint64_t>((record.num_rows + record.block_rows - 1) / record.block_rows);
+    if (record.num_blocks != expected_blocks) return false;
+    if (record.num_resident_blocks != 0 && record.num_resident_blocks != record.num_blocks) return false;
+    if (!in.readArray(rg_idx.block_offsets, record.num_blocks)) return false;
+
+    // Blocs non vides, de debuts strictement croissants dans le row group (lecture de la vue projetee)
+    const IndexArray<uint64_t>& block_offsets = rg_idx.block_offsets;
+    for (uint64_t b = 0; b < record.num_blocks; b++) {
+        const uint64_t block_start = block_offsets[b];
+        if (b == 0 ? block_start != logical_start : block_start <= block_offsets[b - 1]) return false;
+        if (block_start >= logical_next) return false;
+    }
+
+    rg_idx.blocks.resize(record.num_resident_blocks);
+    for (uint64_t b = 0; b < record.num_resident_blocks; b++) {
+        BlockRecord block_record;
+        if (!in.read(block_record)) return false;
+
+        const int64_t first_row = static_cast<int64_t>(b) * record.block_rows;
+        if (block_record.first_row != first_row) return false;
+        if (block_record.num_rows != std::min(record.block_rows, record.num_rows - first_row)) return false;
+        if (block_record.block_logical_end != rg_idx.blockEnd(b)) return false;
+
+        RowBlockIndex& block = rg_idx.blocks[b];
+        block.row_group_id = rg;
+        block.first_row = block_record.first_row;
+        block.num_rows = block_record.num_rows;
+        block.num_columns = num_columns;
+        block.block_logical_end = block_record.block_logical_end;
+
+        const uint64_t num_cells = static_cast<uint64_t>(block_record.num_rows) * num_columns;
+        if (!in.readArray(block.row_offsets, static_cast<uint64_t>(block_record.num_rows))) return false;
+        if (!in.readArray(block.cell_lengths.lengths, num_cells)) return false;
+        if (!in.readArray(block.cell_lengths.long_lengths, block_record.num_long_lengths)) return false;
+        if (!CheckBlock(block, block_offsets[b])) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+SidecarKey SidecarKey::Make(arrow::io::RandomAccessFile& file, int64_t mtime, int64_t checkpoint_rows, const parquet::FileMetaData& metadata, const std::vector<int>& columns, uint32_t num_columns, const std::string& view) {
+    SidecarKey key;
+
+    // Fin du fichier parquet : footer, taille du footer sur 4 octets, "PAR1"
+    PARQUET_ASSIGN_OR_THROW(int64_t file_size, file.GetSize());
+    if (file_size < 8) throw std::runtime_error("Parquet file too small");
+
+    uint8_t tail[8];
+    PARQUET_ASSIGN_OR_THROW(int64_t tail_read, file.ReadAt(file_size - 8, 8, tail));
+    if (tail_read != 8) throw std::runtime_error("Couldn't read parquet footer");
+
+    uint32_t footer_len = static_cast<uint32_t>(tail[0]) | static_cast<uint32_t>(tail[1]) << 8 |
+                          static_cast<uint32_t>(tail[2]) << 16 | static_cast<uint32_t>(tail[3]) << 24;
+    if (static_cast<int64_t>(footer_len) > file_size - 8) throw std::runtime_error("Invalid parquet footer length");
+
+    PARQUET_ASSIGN_OR_THROW(auto footer, file.ReadAt(file_size - 8 - footer_len, footer_len));
+
+    key.file_size = static_cast<uint64_t>(file_size);
+    key.mtime = mtime;
+    key.footer_hash = Fnv1a(tail, sizeof(tail), Fnv1a(footer->data(), static_cast<size_t>(footer->size())));
+    key.checkpoint_rows = checkpoint_rows;
+    key.num_columns = num_columns;
+    key.columns_hash = Fnv1a(reinterpret_cast<const uint8_t*>(columns.data()), columns.size() * sizeof(int));
+    key.view_hash = Fnv1a(reinterpret_cast<const uint8_t*>(view.data()), view.size());
+    key.num_row_groups = static_cast<uint32_t>(metadata.num_row_groups());
+    key.sep = ::sep;
+    return key;
+}
+
+std::string SidecarIndexPath(const std::string& parquet_path, const std::string& cache_dir, const std::string& view) {
+    std::string suffix = ".kpqidx";
+    if (!view.empty()) {
+        char view_tag[24];
+        std::snprintf(view_tag, sizeof(view_tag), ".%016llx",
+                      static_cast<unsigned long long>(Fnv1a(reinterpret_cast<const uint8_t*>(view.data()), view.size())));
+        suffix = view_tag + suffix;
+    }
+
+    if (cache_dir.empty()) {
+        return parquet_path + suffix;
+    }
+
+    // Dans le repertoire de cache, le nom est derive du chemin absolu du fichier
+    std::error_code ec;
+    std::string absolute = std::filesystem::absolute(parquet_path, ec).string();
+    if (ec) absolute = parquet_path;
+
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx",
+                  static_cast<unsigned long long>(Fnv1a(reinterpret_cast<const uint8_t*>(absolute.data()), absolute.size())));
+    return (std::filesystem::path(cache_dir) / (name + suffix)).string();
+}
+
+bool WriteSidecarIndex(const std::string& sidecar_path, const SidecarKey& key, uint64_t logical_size, const std::vector<RowGroupIndex>& row_groups) {
+    // Fichier temporaire propre a ce thread, renomme une fois complet : un lecteur concurrent
+    // ne voit jamais de sidecar partiel
+    const auto tag = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                     static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    const std::string tmp_path = sidecar_path + ".tmp" + std::to_string(tag);
+
+    {
+        SidecarWriter out(tmp_path);
+        if (!out.ok()) return false;
+
+        FileHeader header = {};
+        std::memcpy(header.magic, kSidecarMagic, sizeof(header.magic));
+        header.version = kSidecarVersion;
+        header.byte_order = kByteOrderMark;
+        header.file_size = key.file_size;
+        header.mtime = key.mtime;
+        header.footer_hash = key.footer_hash;
+        header.checkpoint_rows = key.checkpoint_rows;
+        header.num_columns = key.num_columns;
+        header.num_row_groups = key.num_row_groups;
+        header.columns_hash = key.columns_hash;
+        header.view_hash = key.view_hash;
+        header.logical_size = logical_size;
+        header.sep = static_cast<uint8_t>(key.sep);
+        out.write(header);
+
+        for (const auto& rg_idx : row_groups) {
+            RowGroupRecord record = {};
+            record.num_rows = rg_idx.num_rows;
+            record.block_rows = rg_idx.block_rows;
+            record.logical_start = rg_idx.rowgroup_logical_start;
+            record.logical_end = rg_idx.rowgroup_logical_end;
+            record.num_ranges = rg_idx.selection.size();
+            record.num_blocks = rg_idx.block_offsets.size();
+            record.num_resident_blocks = rg_idx.blocks.size();
+            out.write(record);
+            out.writeArray(rg_idx.selection);
+            out.writeArray(rg_idx.block_offsets);
+
+            for (const auto& block : rg_idx.blocks) {
+                BlockRecord block_record = {};
+                block_record.first_row = block.first_row;
+                block_record.num_rows = block.num_rows;
+                block_record.block_logical_end = block.block_logical_end;
+                block_record.num_long_lengths = block.cell_lengths.long_lengths.size();
+                out.write(block_record);
+                out.writeArray(block.row_offsets);
+                out.writeArray(block.cell_lengths.lengths);
+                out.writeArray(block.cell_lengths.long_lengths);
+            }
+        }
+
+        out.close();
+        if (!out.ok()) {
+            std::error_code ec;
+            std::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, sidecar_path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<arrow::Buffer> LoadSidecarIndex(const std::string& sidecar_path, const SidecarKey& key, uint64_t data_start, uint64_t& logical_size, std::vector<RowGroupIndex>& row_groups) {
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(sidecar_path, ec)) return nullptr;
+
+    auto mapped = arrow::io::MemoryMappedFile::Open(sidecar_path, arrow::io::FileMode::READ);
+    if (!mapped.ok()) return nullptr;
+
+    auto size = (*mapped)->GetSize();
+    if (!size.ok() || *size < static_cast<int64_t>(sizeof(FileHeader))) return nullptr;
+
+    // ReadAt sur un fichier projete ne copie pas : le buffer garde la projection ouverte
+    auto buffer = (*mapped)->ReadAt(0, *size);
+    if (!buffer.ok() || (*buffer)->size() != *size) return nullptr;
+
+    SidecarReader in((*buffer)->data(), static_cast<uint64_t>((*buffer)->size()));
+
+    FileHeader header;
+    if (!in.read(header)) return nullptr;
+    if (std::memcmp(header.magic, kSidecarMagic, sizeof(header.magic)) != 0 ||
+        header.version != kSidecarVersion ||
+        header.byte_order != kByteOrderMark ||
+        header.file_size != key.file_size ||
+        header.mtime != key.mtime ||
+        header.footer_hash != key.footer_hash ||
+        header.checkpoint_rows != key.checkpoint_rows ||
+        header.num_columns != key.num_columns ||
+        header.num_row_groups != key.num_row_groups ||
+        header.columns_hash != key.columns_hash ||
+        header.view_hash != key.view_hash ||
+        header.sep != static_cast<uint8_t>(key.sep)) {
+        return nullptr;
+    }
+
+    // Row groups contigus, du debut des lignes a la fin du fichier logique
+    std::vector<RowGroupIndex> loaded(header.num_row_groups);
+    uint64_t logical_start = data_start;
+    for (uint32_t rg = 0; rg < header.num_row_groups; rg++) {
+        if (!ReadRowGroup(in, static_cast<int>(rg), header.num_columns, logical_start, loaded[rg])) return nullptr;
+        logical_start = loaded[rg].rowgroup_logical_end + 1;
+    }
+    if (!in.atEnd() || logical_start != header.logical_size) return nullptr;
+
+    logical_size = header.logical_size;
+    row_groups = std::move(loaded);
+    return *buffer;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <arrow/buffer.h>
+#include <arrow/io/interfaces.h>
+#include <parquet/metadata.h>
+
+#include "parquet_file.h"
+
+// Index logique persistant ("sidecar") d'un fichier parquet.
+// Sur demande (KHIOPS_PARQUET_SIDECAR_INDEX=1, ou un repertoire de cache KHIOPS_PARQUET_INDEX_DIR), l'index
+// construit a la premiere ouverture est ecrit dans un fichier <fichier>.kpqidx (ou dans le repertoire de
+// cache), puis projete en memoire aux ouvertures suivantes au lieu de decoder le fichier.
+// Le sidecar n'est reutilise que si le fichier parquet et les options d'indexation sont inchanges.
+
+// Identite du fichier parquet et des options ayant servi a construire l'index
+struct SidecarKey {
+    uint64_t file_size = 0;
+    int64_t mtime = 0;
+    uint64_t footer_hash = 0;       // FNV-1a du footer parquet
+    int64_t checkpoint_rows = 0;    // 0 : index dense, -1 : index paresseux
+    uint32_t num_columns = 0;       // colonnes rendues, colonnes de partition comprises
+    uint64_t columns_hash = 0;      // FNV-1a des indices des colonnes projetees
+    uint64_t view_hash = 0;         // FNV-1a de la vue (projection, filtre, partitions, en-tete)
+    uint32_t num_row_groups = 0;
+    char sep = '\t';
+
+    // Throws if the footer cannot be read
+    static SidecarKey Make(arrow::io::RandomAccessFile& file,
+                           int64_t mtime,
+                           int64_t checkpoint_rows,
+                           const parquet::FileMetaData& metadata,
+                           const std::vector<int>& columns,
+                           uint32_t num_columns,
+                           const std::string& view);
+};
+
+// Chemin du sidecar : a cote du fichier parquet, ou dans cache_dir s'il est renseigne.
+// Chaque vue du fichier (projection et filtre, vide pour toutes les colonnes et lignes) a son propre sidecar.
+std::string SidecarIndexPath(const std::string& parquet_path, const std::string& cache_dir, const std::string& view);
+
+// Ecrit l'index dans un fichier temporaire renomme ensuite en sidecar_path.
+// Returns false on failure; the caller keeps its in-memory index.
+bool WriteSidecarIndex(const std::string& sidecar_path,
+                       const SidecarKey& key,
+                       uint64_t logical_size,
+                       const std::vector<RowGroupIndex>& row_groups);
+
+// Projette le sidecar en memoire et remplit row_groups avec des vues sur son contenu, les lignes
+// commencant a data_start (apres l'en-tete). Les offsets et longueurs sont verifies au chargement.
+// Returns the mapped buffer, which must outlive row_groups, or nullptr if the sidecar
+// is missing, stale or corrupted.
+std::shared_ptr<arrow::Buffer> LoadSidecarIndex(const std::string& sidecar_path,
+                                                const SidecarKey& key,
+                                                uint64_t data_start,
+                                                uint64_t& logical_size,
+                                                std::vector<RowGroupIndex>& row_groups);
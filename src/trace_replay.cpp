@@ -0,0 +1,271 @@
+// Rejeu d'une trace d'appels du driver (voir call_trace.h) : les appels sont refaits dans l'ordre de leur
+// debut, sur un seul thread, et leurs latences comparees a celles de la trace. Les resultats sont ecrits en JSON.
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bench_report.h"
+#include "call_trace.h"
+#include "khiopsdriver_file_parquet.h"
+
+namespace {
+
+const char* kUsage =
+    "Usage: parquet_reader_replay TRACE [options]\n"
+    "Replays a trace recorded with KHIOPS_PARQUET_TRACE=<file> and reports the latencies of each driver call.\n"
+    "  --path-map FROM=TO   replace the prefix FROM of the traced file names by TO (repeatable)\n"
+    "  --repeat N           number of replays (default 1)\n"
+    "  --dump               print the calls of the trace instead of replaying it\n"
+    "  --json PATH          results file (default: standard output)\n"
+    "Concurrent calls of the trace are replayed one after the other, in the order they started.\n";
+
+struct ReplayOptions {
+    std::string trace;
+    std::vector<std::pair<std::string, std::string>> path_map;
+    int repeat = 1;
+    bool dump = false;
+    std::string json;
+};
+
+ReplayOptions ParseOptions(int argc, char** argv) {
+    ReplayOptions options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            std::cout << kUsage;
+            std::exit(0);
+        }
+        if (arg == "--dump") {
+            options.dump = true;
+            continue;
+        }
+        if (arg.compare(0, 2, "--") != 0) {
+            if (!options.trace.empty()) throw std::runtime_error("Several trace files given\n" + std::string(kUsage));
+            options.trace = arg;
+            continue;
+        }
+        if (i + 1 >= argc) throw std::runtime_error("Missing value for " + arg);
+        const std::string value = argv[++i];
+
+        if (arg == "--path-map") {
+            const size_t eq = value.find('=');
+            if (eq == std::string::npos || eq == 0) throw std::runtime_error("Invalid value for --path-map: " + value);
+            options.path_map.emplace_back(value.substr(0, eq), value.substr(eq + 1));
+        }
+        else if (arg == "--repeat") options.repeat = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--json") options.json = value;
+        else throw std::runtime_error("Unknown option: " + arg + "\n" + kUsage);
+    }
+    if (options.trace.empty()) throw std::runtime_error(std::string("Missing trace file\n") + kUsage);
+    return options;
+}
+
+std::string MapPath(const std::string& path, const ReplayOptions& options) {
+    for (const auto& mapping : options.path_map) {
+        if (path.compare(0, mapping.first.size(), mapping.first) == 0) {
+            return mapping.second + path.substr(mapping.first.size());
+        }
+    }
+    return path;
+}
+
+std::string ValuesText(const std::vector<int64_t>& values) {
+    std::string text = "[";
+    for (size_t i = 0; i < values.size(); i++) {
+        if (i > 0) text += ", ";
+        text += std::to_string(values[i]);
+    }
+    return text + "]";
+}
+
+void Dump(const std::vector<TraceRecord>& records) {
+    for (const TraceRecord& record : records) {
+        std::cout << record.start_ns / 1000 << "us thread " << record.thread << " stream " << record.stream << " "
+                  << TraceCallName(record.call) << "(";
+        if (!record.path.empty()) std::cout << record.path << (record.call == TraceCall::Open ? ", " : "");
+        if (record.call == TraceCall::Open) std::cout << static_cast<char>(record.args[0]);
+        else if (record.call == TraceCall::LineOffset) std::cout << record.args[0];
+        else if (record.call == TraceCall::SplitPoints) std::cout << ValuesText(record.targets) << ", " << record.args[1];
+        else if (record.call != TraceCall::Close && record.path.empty()) std::cout << record.args[0] << ", " << record.args[1];
+        std::cout << ") = " << record.result;
+        if (record.call == TraceCall::SplitPoints && record.result == 0) std::cout << " " << ValuesText(record.split_points);
+        std::cout << " [" << static_cast<double>(record.duration_ns) / 1000 << "us]\n";
+    }
+}
+
+// Latences et resultats d'un type d'appel
+struct CallStats {
+    std::vector<double> recorded_us;
+    std::vector<double> replayed_us;
+    uint64_t mismatches = 0;            // resultat (ou points de coupure) different de celui de la trace
+    uint64_t skipped = 0;               // appels sur un flux qui n'a pas pu etre rouvert
+};
+
+// Rejoue les appels une fois ; les flux restes ouverts dans la trace sont fermes a la fin
+void Replay(const std::vector<TraceRecord>& records, const ReplayOptions& options, std::map<TraceCall, CallStats>& stats) {
+    std::unordered_map<uint32_t, void*> streams;
+    std::vector<char> buffer;
+    std::vector<long long> targets;
+    std::vector<long long> split_points;
+
+    for (const TraceRecord& record : records) {
+        CallStats& call_stats = stats[record.call];
+
+        void* stream = nullptr;
+        if (record.call != TraceCall::FileExists && record.call != TraceCall::DirExists &&
+            record.call != TraceCall::GetFileSize && record.call != TraceCall::Open) {
+            auto it = streams.find(record.stream);
+            if (it == streams.end()) {
+                call_stats.skipped++;
+                continue;
+            }
+            stream = it->second;
+        }
+
+        size_t len = 0;
+        if (record.call == TraceCall::Read) len = static_cast<size_t>(record.args[0] * record.args[1]);
+        else if (record.call == TraceCall::PositionalRead) len = static_cast<size_t>(record.args[1]);
+        if (buffer.size() < len) buffer.resize(len);
+        if (record.call == TraceCall::SplitPoints) {
+            targets.assign(record.targets.begin(), record.targets.end());
+            split_points.assign(targets.size(), 0);
+        }
+
+        const std::string path = MapPath(record.path, options);
+        long long result = 0;
+        const Clock::time_point start = Clock::now();
+        switch (record.call) {
+        case TraceCall::FileExists: result = driver_fileExists(path.c_str()); break;
+        case TraceCall::DirExists: result = driver_dirExists(path.c_str()); break;
+        case TraceCall::GetFileSize: result = driver_getFileSize(path.c_str()); break;
+        case TraceCall::Open:
+            stream = driver_fopen(path.c_str(), static_cast<char>(record.args[0]));
+            result = stream != nullptr ? 1 : 0;
+            break;
+        case TraceCall::Close: result = driver_fclose(stream); break;
+        case TraceCall::Read: result = driver_fread(buffer.data(), static_cast<size_t>(record.args[0]), static_cast<size_t>(record.args[1]), stream); break;
+        case TraceCall::PositionalRead: result = driver_pread(stream, record.args[0], buffer.data(), len); break;
+        case TraceCall::Seek: result = driver_fseek(stream, record.args[0], static_cast<int>(record.args[1])); break;
+        case TraceCall::LineOffset: result = driver_getLineOffset(stream, record.args[0]); break;
+        case TraceCall::SplitPoints:
+            // Cibles absentes de la trace : l'appel avait ete fait sans tableau de cibles
+            if (targets.empty()) result = driver_getSplitPoints(stream, nullptr, nullptr, static_cast<size_t>(record.args[0]), record.args[1]);
+            else result = driver_getSplitPoints(stream, targets.data(), split_points.data(), targets.size(), record.args[1]);
+            break;
+        }
+        call_stats.replayed_us.push_back(ElapsedUs(start));
+        if (result != record.result) call_stats.mismatches++;
+        else if (record.call == TraceCall::SplitPoints && result == 0 &&
+                 !std::equal(split_points.begin(), split_points.end(), record.split_points.begin(), record.split_points.end())) {
+            call_stats.mismatches++;
+        }
+
+        if (record.call == TraceCall::Open && stream != nullptr) {
+            // Ouverture en echec dans la trace : aucun appel ne porte sur ce flux
+            if (record.stream == 0) driver_fclose(stream);
+            else streams[record.stream] = stream;
+        }
+        if (record.call == TraceCall::Close) streams.erase(record.stream);
+    }
+
+    for (const auto& entry : streams) {
+        driver_fclose(entry.second);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const ReplayOptions options = ParseOptions(argc, argv);
+        const char* trace_output = std::getenv("KHIOPS_PARQUET_TRACE");
+        if (trace_output != nullptr && options.trace == trace_output) {
+            throw std::runtime_error("KHIOPS_PARQUET_TRACE would overwrite the replayed trace");
+        }
+        std::vector<TraceRecord> records = ReadTrace(options.trace);
+        std::stable_sort(records.begin(), records.end(),
+            [](const TraceRecord& a, const TraceRecord& b) { return a.start_ns < b.start_ns; });
+
+        if (options.dump) {
+            Dump(records);
+            return 0;
+        }
+
+        std::map<TraceCall, CallStats> stats;
+        for (const TraceRecord& record : records) {
+            stats[record.call].recorded_us.push_back(static_cast<double>(record.duration_ns) / 1000);
+        }
+
+        driver_connect();
+        const Clock::time_point start = Clock::now();
+        for (int r = 0; r < options.repeat; r++) {
+            Replay(records, options, stats);
+        }
+        const double seconds = ElapsedUs(start) / 1e6;
+        driver_disconnect();
+
+        uint32_t threads = 0;
+        uint32_t streams = 0;
+        for (const TraceRecord& record : records) {
+            threads = std::max(threads, record.thread);
+            streams = std::max(streams, record.stream);
+        }
+        const uint64_t span_ns = records.empty() ? 0 : records.back().start_ns + records.back().duration_ns - records.front().start_ns;
+
+        JsonObject calls;
+        uint64_t mismatches = 0;
+        uint64_t skipped = 0;
+        for (const auto& entry : stats) {
+            const CallStats& call_stats = entry.second;
+            mismatches += call_stats.mismatches;
+            skipped += call_stats.skipped;
+            calls.addJson(TraceCallName(entry.first), JsonObject()
+                .add("count", static_cast<uint64_t>(call_stats.recorded_us.size()))
+                .add("mismatches", call_stats.mismatches)
+                .add("skipped", call_stats.skipped)
+                .addJson("recorded", LatencyStats(call_stats.recorded_us))
+                .addJson("replayed", LatencyStats(call_stats.replayed_us))
+                .str());
+        }
+
+        JsonObject results;
+        results.addJson("driver", JsonObject().add("name", driver_getDriverName()).add("version", driver_getVersion()).str())
+            .addJson("trace", JsonObject()
+                .add("path", options.trace)
+                .add("calls", static_cast<uint64_t>(records.size()))
+                .add("threads", static_cast<uint64_t>(threads))
+                .add("streams", static_cast<uint64_t>(streams))
+                .add("seconds", static_cast<double>(span_ns) / 1e9)
+                .str())
+            .addJson("replay", JsonObject()
+                .add("repeat", static_cast<int64_t>(options.repeat))
+                .add("seconds", seconds)
+                .add("mismatches", mismatches)
+                .add("skipped", skipped)
+                .add("peak_rss_bytes", PeakRssBytes())
+                .str())
+            .addJson("calls", calls.str(true));
+
+        const std::string json = results.str(true) + "\n";
+        if (options.json.empty()) {
+            std::cout << json;
+        }
+        else {
+            std::ofstream out(options.json);
+            out << json;
+            if (!out) throw std::runtime_error("Unable to write " + options.json);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "parquet_reader_replay: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <parquet/types.h>
+
+// Detection vectorielle des caracteres a echapper : AVX2 si le compilateur le cible, sinon SSE2
+#if defined(__AVX2__)
+#define VALUE_FORMAT_AVX2
+#define VALUE_FORMAT_SSE2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VALUE_FORMAT_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Separateur de champs du flux rendu
+extern char sep;
+
+// Formatage textuel des valeurs, commun a la construction de l'index et au rendu :
+// FormattedLength(v) est toujours exactement le nombre d'octets ecrits par FormatValue(v, out).
+//  - entiers : ecriture decimale
+//  - FLOAT / DOUBLE : plus courte representation relisible a l'identique (std::to_chars)
+//  - BYTE_ARRAY : valeur brute, entre guillemets (guillemets internes doubles) si elle contient
+//    un guillemet, un retour a la ligne ou le separateur
+
+// Taille maximale d'un nombre formate
+constexpr size_t kMaxNumberLength = 32;
+
+namespace value_format_detail {
+
+constexpr char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+inline uint32_t DecimalLength(uint64_t v) {
+    uint32_t n = 1;
+    for (;;) {
+        if (v < 10) return n;
+        if (v < 100) return n + 1;
+        if (v < 1000) return n + 2;
+        if (v < 10000) return n + 3;
+        v /= 10000;
+        n += 4;
+    }
+}
+
+// Ecrit les len chiffres de v en partant de la fin, deux chiffres a la fois
+inline void WriteDecimal(uint64_t v, uint32_t len, uint8_t* out) {
+    uint8_t* p = out + len;
+    while (v >= 100) {
+        const uint64_t pair = (v % 100) * 2;
+        v /= 100;
+        *--p = kDigitPairs[pair + 1];
+        *--p = kDigitPairs[pair];
+    }
+    if (v >= 10) {
+        *--p = kDigitPairs[v * 2 + 1];
+        *--p = kDigitPairs[v * 2];
+    }
+    else {
+        *--p = static_cast<uint8_t>('0' + v);
+    }
+}
+
+inline uint64_t Magnitude(int64_t v) {
+    return v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+}
+
+template <typename T>
+inline size_t FormatFloating(T v, uint8_t* out) {
+    char* first = reinterpret_cast<char*>(out);
+    return static_cast<size_t>(std::to_chars(first, first + kMaxNumberLength, v).ptr - first);
+}
+
+inline bool IsSpecial(uint8_t c) {
+    return c == '"' || c == '\n' || c == '\r' || c == static_cast<uint8_t>(sep);
+}
+
+inline uint32_t PopCount(uint32_t v) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return __popcnt(v);
+#else
+    return static_cast<uint32_t>(__builtin_popcount(v));
+#endif
+}
+
+#ifdef VALUE_FORMAT_SSE2
+// Masque des octets de chunk egaux a un des caracteres speciaux, et masque des guillemets
+inline uint32_t SpecialMask(__m128i chunk, uint32_t& quote_mask) {
+    const __m128i q = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+    const __m128i others = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))),
+        _mm_cmpeq_epi8(chunk, _mm_set1_epi8(sep)));
+    quote_mask = static_cast<uint32_t>(_mm_movemask_epi8(q));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(q, others)));
+}
+#endif
+
+#ifdef VALUE_FORMAT_AVX2
+inline uint32_t SpecialMask(__m256i chunk, uint32_t& quote_mask) {
+    const __m256i q = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'));
+    const __m256i others = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r'))),
+        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(sep)));
+    quote_mask = static_cast<uint32_t>(_mm256_movemask_epi8(q));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(q, others)));
+}
+#endif
+
+// Recherche des caracteres speciaux de p[0, len), 16 ou 32 octets par iteration.
+// Returns true if the value must be quoted; quotes receives the number of '"' when
+// count_quotes is set, otherwise the scan stops at the first special character.
+inline bool ScanSpecials(const uint8_t* p, uint32_t len, bool count_quotes, uint64_t& quotes) {
+    bool need_quote = false;
+    uint32_t quote_mask;
+    uint32_t i = 0;
+    quotes = 0;
+
+#ifdef VALUE_FORMAT_AVX2
+    for (; i + 32 <= len; i += 32) {
+        if (SpecialMask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)), quote_mask) != 0) {
+            need_quote = true;
+            if (!count_quotes) return true;
+            quotes += PopCount(quote_mask);
+        }
+    }
+#endif
+#ifdef VALUE_FORMAT_SSE2
+    for (; i + 16 <= len; i += 16) {
+        if (SpecialMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), quote_mask) != 0) {
+            need_quote = true;
+            if (!count_quotes) return true;
+            quotes += PopCount(quote_mask);
+        }
+    }
+#endif
+    for (; i < len; ++i) {
+        if (IsSpecial(p[i])) {
+            need_quote = true;
+            if (!count_quotes) return true;
+            quotes += p[i] == '"';
+        }
+    }
+    return need_quote;
+}
+
+// Copie p[0, len) dans out en doublant les guillemets ; les blocs sans guillemet sont copies d'un coup
+inline uint8_t* CopyDoublingQuotes(const uint8_t* p, uint32_t len, uint8_t* out) {
+    uint32_t i = 0;
+
+#ifdef VALUE_FORMAT_SSE2
+    const __m128i q = _mm_set1_epi8('"');
+    for (; i + 16 <= len; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, q)) == 0) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chunk);
+            out += 16;
+            continue;
+        }
+        for (uint32_t j = i; j < i + 16; ++j) {
+            if (p[j] == '"') {
+                *out++ = '"';
+            }
+            *out++ = p[j];
+        }
+    }
+#endif
+    for (; i < len; ++i) {
+        if (p[i] == '"') {
+            *out++ = '"';
+        }
+        *out++ = p[i];
+    }
+    return out;
+}
+
+} // namespace value_format_detail
+
+inline uint64_t FormattedLength(int64_t v) {
+    return (v < 0) + value_format_detail::DecimalLength(value_format_detail::Magnitude(v));
+}
+
+inline size_t FormatValue(int64_t v, uint8_t* out) {
+    const uint32_t neg = v < 0;
+    const uint32_t len = value_format_detail::DecimalLength(value_format_detail::Magnitude(v));
+    *out = '-';
+    value_format_detail::WriteDecimal(value_format_detail::Magnitude(v), len, out + neg);
+    return neg + len;
+}
+
+inline uint64_t FormattedLength(int32_t v) { return FormattedLength(static_cast<int64_t>(v)); }
+
+inline size_t FormatValue(int32_t v, uint8_t* out) { return FormatValue(static_cast<int64_t>(v), out); }
+
+inline size_t FormatValue(double v, uint8_t* out) { return value_format_detail::FormatFloating(v, out); }
+
+inline size_t FormatValue(float v, uint8_t* out) { return value_format_detail::FormatFloating(v, out); }
+
+inline uint64_t FormattedLength(double v) {
+    uint8_t buf[kMaxNumberLength];
+    return FormatValue(v, buf);
+}
+
+inline uint64_t FormattedLength(float v) {
+    uint8_t buf[kMaxNumberLength];
+    return FormatValue(v, buf);
+}
+
+inline uint64_t FormattedLength(const parquet::ByteArray& v) {
+    if (v.ptr == nullptr || v.len == 0) return 0;
+
+    uint64_t quotes;
+    if (!value_format_detail::ScanSpecials(v.ptr, v.len, true, quotes)) return v.len;
+    return v.len + quotes + 2;
+}
+
+inline size_t FormatValue(const parquet::ByteArray& v, uint8_t* out) {
+    if (v.ptr == nullptr || v.len == 0) return 0;
+
+    uint64_t quotes;
+    if (!value_format_detail::ScanSpecials(v.ptr, v.len, false, quotes)) {
+        std::memcpy(out, v.ptr, v.len);
+        return v.len;
+    }
+
+    uint8_t* p = out;
+    *p++ = '"';
+    p = value_format_detail::CopyDoublingQuotes(v.ptr, v.len, p);
+    *p++ = '"';
+    return static_cast<size_t>(p - out);
+}
+
+// Un dictionnaire n'est exploite que si ses entrees sont en moyenne referencees au moins
+// kMinDictionaryReuse fois ; sinon les valeurs sont decodees et formatees directement
+constexpr int64_t kMinDictionaryReuse = 2;
+
+// Rendu memoise des entrees d'un dictionnaire de valeurs : la taille et le rendu de chaque entree
+// sont calcules a sa premiere utilisation, puis reutilises pour toutes les lignes qui la referencent
+template <typename T>
+class DictionaryText {
+
+    public:
+        // Change de dictionnaire ; sans effet s'il s'agit du dictionnaire courant
+        void reset(const T* dict, int32_t dict_len) {
+            if (dict == source && dict_len == source_len) return;
+            source = dict;
+            source_len = dict_len;
+            lengths.assign(static_cast<size_t>(dict_len), kUnknown);
+            starts.clear();
+            text.clear();
+        }
+
+        uint64_t length(int32_t index) {
+            check(index);
+            if (lengths[index] == kUnknown) {
+                lengths[index] = FormattedLength(source[index]);
+            }
+            return lengths[index];
+        }
+
+        size_t write(int32_t index, uint8_t* out) {
+            check(index);
+            if (starts.empty()) {
+                starts.assign(static_cast<size_t>(source_len), kUnknown);
+            }
+            if (starts[index] == kUnknown) {
+                const uint64_t start = text.size();
+                text.resize(start + length(index));
+                FormatValue(source[index], text.data() + start);
+                starts[index] = start;
+            }
+            std::memcpy(out, text.data() + starts[index], lengths[index]);
+            return lengths[index];
+        }
+
+    private:
+        static constexpr uint64_t kUnknown = ~0ull;
+
+        const T* source = nullptr;
+        int32_t source_len = 0;
+        std::vector<uint64_t> lengths;
+        std::vector<uint64_t> starts;       // debut du rendu de chaque entree dans text
+        std::vector<uint8_t> text;
+
+        void check(int32_t index) const {
+            if (index < 0 || index >= source_len) throw std::runtime_error("Invalid dictionary index");
+        }
+};